@@ -0,0 +1,90 @@
+#include "BinaryFormat.h"
+#include <algorithm>
+
+BinaryFormat::Writer::Writer(std::ostream& out, Kind kind)
+	: m_out(out)
+	, m_position(0)
+{
+	Write(kMagic);
+	Write(static_cast<uint32_t>(kind));
+	Write(kVersion);
+	Write(kByteOrderMark);
+}
+
+void BinaryFormat::Writer::WriteStrings(const std::vector<std::string>& strings)
+{
+	// All the characters in one array; string i is [offsets[i], offsets[i + 1]).
+	std::vector<uint32_t> offsets{ 0 };
+	std::string characters;
+	for (const std::string& string : strings) {
+		characters += string;
+		offsets.push_back(static_cast<uint32_t>(characters.size()));
+	}
+	WriteArray(std::span<const uint32_t>(offsets));
+	WriteArray(std::span<const char>(characters.data(), characters.size()));
+}
+
+void BinaryFormat::Writer::mf_Align(size_t alignment)
+{
+	static const char padding[8] = {};
+	mf_WriteBytes(padding, (alignment - m_position % alignment) % alignment);
+}
+
+void BinaryFormat::Writer::mf_WriteBytes(const void* data, size_t size)
+{
+	m_out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+	if (!m_out) {
+		throw "The binary image could not be written.";
+	}
+	m_position += size;
+}
+
+BinaryFormat::Reader::Reader(std::span<const uint8_t> bytes, Kind kind)
+	: m_bytes(bytes)
+	, m_position(0)
+{
+	if (bytes.size() < 16 || Read<uint32_t>() != kMagic || Read<uint32_t>() != static_cast<uint32_t>(kind)) {
+		throw "The file is not a binary image of this kind.";
+	}
+	if (Read<uint32_t>() != kVersion) {
+		throw "The binary image has an unsupported version.";
+	}
+	if (Read<uint32_t>() != kByteOrderMark) {
+		throw "The binary image was written with another byte order.";
+	}
+}
+
+std::vector<std::string> BinaryFormat::Reader::ReadStrings()
+{
+	const std::span<const uint32_t> offsets = ReadArray<uint32_t>();
+	const std::span<const char> characters = ReadArray<char>();
+	// The whole table is checked before any string is built, so every offset is within the characters.
+	if (offsets.empty() || offsets.front() != 0 || offsets.back() != characters.size()
+		|| !std::is_sorted(offsets.begin(), offsets.end())) {
+		throw "The binary image is not valid.";
+	}
+	std::vector<std::string> strings;
+	strings.reserve(offsets.size() - 1);
+	for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+		strings.emplace_back(characters.data() + offsets[i], offsets[i + 1] - offsets[i]);
+	}
+	return strings;
+}
+
+void BinaryFormat::Reader::mf_Align(size_t alignment)
+{
+	m_position += (alignment - m_position % alignment) % alignment;
+	if (m_position > m_bytes.size()) {
+		m_position = m_bytes.size();
+	}
+}
+
+const uint8_t* BinaryFormat::Reader::mf_Take(size_t size)
+{
+	if (size > m_bytes.size() - m_position) {
+		throw "The binary image is truncated.";
+	}
+	const uint8_t* data = m_bytes.data() + m_position;
+	m_position += size;
+	return data;
+}
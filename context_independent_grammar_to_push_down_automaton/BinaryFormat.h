@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Versioned binary images of compiled objects. An image is a 16-byte header (magic, kind, version, byte
+// order) followed by scalars and arrays, each aligned to its own size and arrays to 8 bytes, so an image
+// mapped at a page boundary can be read in place: Reader hands out spans into the bytes instead of
+// parsing them. Images are written in the byte order of the machine and rejected on one that differs.
+class BinaryFormat
+{
+public:
+	enum class Kind : uint32_t
+	{
+		Grammar = 1,
+		PushDownAutomaton = 2
+	};
+
+public:
+	static constexpr uint32_t kMagic = 0x4246434C; // "LCFB" read as little endian bytes
+	static constexpr uint32_t kVersion = 3;
+	static constexpr uint32_t kByteOrderMark = 0x01020304;
+
+public:
+	class Writer
+	{
+	public:
+		Writer(std::ostream& out, Kind kind);
+
+	public:
+		template <typename T>
+		void Write(const T& value);
+		template <typename T>
+		void WriteArray(std::span<const T> values);
+		void WriteStrings(const std::vector<std::string>& strings);
+
+	private:
+		void mf_Align(size_t alignment);
+		void mf_WriteBytes(const void* data, size_t size);
+
+	private:
+		std::ostream& m_out;
+		size_t m_position;
+	};
+
+	class Reader
+	{
+	public:
+		Reader(std::span<const uint8_t> bytes, Kind kind);
+
+	public:
+		template <typename T>
+		T Read();
+		template <typename T>
+		std::span<const T> ReadArray();
+		std::vector<std::string> ReadStrings();
+
+	private:
+		void mf_Align(size_t alignment);
+		const uint8_t* mf_Take(size_t size);
+
+	private:
+		std::span<const uint8_t> m_bytes;
+		size_t m_position;
+	};
+};
+
+template <typename T>
+void BinaryFormat::Writer::Write(const T& value)
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	mf_Align(alignof(T));
+	mf_WriteBytes(&value, sizeof(T));
+}
+
+template <typename T>
+void BinaryFormat::Writer::WriteArray(std::span<const T> values)
+{
+	static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= 8);
+	Write<uint64_t>(values.size());
+	mf_WriteBytes(values.data(), values.size_bytes());
+	mf_Align(8);
+}
+
+template <typename T>
+T BinaryFormat::Reader::Read()
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	mf_Align(alignof(T));
+	T value;
+	std::memcpy(&value, mf_Take(sizeof(T)), sizeof(T));
+	return value;
+}
+
+template <typename T>
+std::span<const T> BinaryFormat::Reader::ReadArray()
+{
+	static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= 8);
+	const uint64_t count = Read<uint64_t>();
+	if (count > (m_bytes.size() - m_position) / sizeof(T)) {
+		throw "The binary image is truncated.";
+	}
+	const uint8_t* data = mf_Take(static_cast<size_t>(count) * sizeof(T));
+	if (reinterpret_cast<uintptr_t>(data) % alignof(T)) {
+		throw "The binary image is not aligned.";
+	}
+	mf_Align(8);
+	return std::span<const T>(reinterpret_cast<const T*>(data), static_cast<size_t>(count));
+}
@@ -0,0 +1,157 @@
+#include "CYKRecognizer.h"
+#include <algorithm>
+#include <bit>
+#include <map>
+
+CYKRecognizer::CYKRecognizer(const Grammar& chomskyGrammar)
+	: m_nonterminals(chomskyGrammar.GetNonterminalSymbols())
+	, m_wordsPerSet((chomskyGrammar.GetNonterminalSymbols().size() + 63) / 64)
+	, m_acceptsEmptyWord(false)
+	, m_inputSplitter(chomskyGrammar)
+{
+	const SymbolTable& symbolTable = chomskyGrammar.GetSymbolTable();
+	m_nonterminalIndexes.assign(symbolTable.Size(), kNoSymbol);
+	for (size_t i = 0; i < m_nonterminals.size(); ++i) {
+		m_nonterminalIndexes[m_nonterminals[i]] = static_cast<uint32_t>(i);
+	}
+	const std::vector<Grammar::Symbol>& terminals = chomskyGrammar.GetTerminalSymbols();
+	m_terminalIndexes.assign(symbolTable.Size(), kNoSymbol);
+	for (size_t i = 0; i < terminals.size(); ++i) {
+		m_terminalIndexes[terminals[i]] = static_cast<uint32_t>(i);
+	}
+	m_startIndex = mf_GetNonterminalIndex(chomskyGrammar.GetStartSymbol());
+	m_terminalSets.assign(terminals.size() * m_wordsPerSet, 0);
+
+	std::map<std::pair<uint32_t, uint32_t>, std::vector<uint32_t>> binaryRules;
+	for (const auto& [left, right] : chomskyGrammar.GetProductions()) {
+		const uint32_t leftIndex = left.size() == 1 ? mf_GetNonterminalIndex(left[0]) : kNoSymbol;
+		if (leftIndex == kNoSymbol) {
+			throw "The grammar is not in Chomsky normal form.";
+		}
+		if (right.size() == 1 && right[0] == Grammar::kLambdaSymbol) {
+			if (leftIndex != m_startIndex) {
+				throw "The grammar is not in Chomsky normal form.";
+			}
+			m_acceptsEmptyWord = true;
+			continue;
+		}
+		if (right.size() == 1 && right[0] < m_terminalIndexes.size() && m_terminalIndexes[right[0]] != kNoSymbol) {
+			mf_Set(m_terminalSets.data() + m_terminalIndexes[right[0]] * m_wordsPerSet, leftIndex);
+			continue;
+		}
+		const uint32_t firstIndex = right.size() == 2 ? mf_GetNonterminalIndex(right[0]) : kNoSymbol;
+		const uint32_t secondIndex = right.size() == 2 ? mf_GetNonterminalIndex(right[1]) : kNoSymbol;
+		if (firstIndex == kNoSymbol || secondIndex == kNoSymbol) {
+			throw "The grammar is not in Chomsky normal form.";
+		}
+		binaryRules[{ firstIndex, secondIndex }].push_back(leftIndex);
+	}
+
+	m_pairedSymbols.assign(m_nonterminals.size() * m_wordsPerSet, 0);
+	m_ruleOffsets.assign(m_nonterminals.size() + 1, 0);
+	m_ruleLeftSets.assign(binaryRules.size() * m_wordsPerSet, 0);
+	m_ruleRightSymbols.reserve(binaryRules.size());
+	for (const auto& [pair, leftIndexes] : binaryRules) {
+		const auto& [firstIndex, secondIndex] = pair;
+		mf_Set(m_pairedSymbols.data() + firstIndex * m_wordsPerSet, secondIndex);
+		++m_ruleOffsets[firstIndex + 1];
+		for (uint32_t leftIndex : leftIndexes) {
+			mf_Set(m_ruleLeftSets.data() + m_ruleRightSymbols.size() * m_wordsPerSet, leftIndex);
+		}
+		m_ruleRightSymbols.push_back(secondIndex);
+	}
+	for (size_t i = 1; i < m_ruleOffsets.size(); ++i) {
+		m_ruleOffsets[i] += m_ruleOffsets[i - 1];
+	}
+}
+
+bool CYKRecognizer::Accepts(std::string_view word) const
+{
+	if (m_startIndex == kNoSymbol) {
+		return false;
+	}
+	if (word.empty()) {
+		return m_acceptsEmptyWord;
+	}
+
+	const size_t n = word.size();
+	std::vector<uint32_t> matchOffsets;
+	std::vector<InputSplitter::Match> matches;
+	m_inputSplitter.Split(word, matchOffsets, matches);
+	// A word that no split covers is rejected before the table is filled.
+	std::vector<uint8_t> isCovered(n + 1, 0);
+	isCovered[0] = 1;
+	for (size_t i = 0; i < n; ++i) {
+		for (uint32_t m = matchOffsets[i]; isCovered[i] && m < matchOffsets[i + 1]; ++m) {
+			isCovered[i + matches[m].length] = 1;
+		}
+	}
+	if (!isCovered[n]) {
+		return false;
+	}
+
+	// The cell of the subword starting at i with length l is (l - 1) * n + i.
+	const size_t words = m_wordsPerSet;
+	std::vector<uint64_t> table(n * n * words, 0);
+	auto cell = [&table, n, words](size_t start, size_t length) {
+		return table.data() + ((length - 1) * n + start) * words;
+	};
+
+	for (size_t i = 0; i < n; ++i) {
+		for (uint32_t m = matchOffsets[i]; m < matchOffsets[i + 1]; ++m) {
+			const uint64_t* terminalSet = m_terminalSets.data() + m_terminalIndexes[matches[m].symbol] * words;
+			uint64_t* target = cell(i, matches[m].length);
+			for (size_t k = 0; k < words; ++k) {
+				target[k] |= terminalSet[k];
+			}
+		}
+	}
+
+	for (size_t length = 2; length <= n; ++length) {
+		for (size_t start = 0; start + length <= n; ++start) {
+			uint64_t* target = cell(start, length);
+			for (size_t split = 1; split < length; ++split) {
+				const uint64_t* left = cell(start, split);
+				const uint64_t* right = cell(start + split, length - split);
+				for (size_t w = 0; w < words; ++w) {
+					for (uint64_t bits = left[w]; bits; bits &= bits - 1) {
+						const uint32_t first = static_cast<uint32_t>(w * 64 + std::countr_zero(bits));
+						const uint64_t* paired = m_pairedSymbols.data() + first * words;
+						uint64_t common = 0;
+						for (size_t k = 0; k < words; ++k) {
+							common |= paired[k] & right[k];
+						}
+						if (!common) {
+							continue;
+						}
+						for (uint32_t rule = m_ruleOffsets[first]; rule < m_ruleOffsets[first + 1]; ++rule) {
+							if (!mf_Test(right, m_ruleRightSymbols[rule])) {
+								continue;
+							}
+							const uint64_t* leftSet = m_ruleLeftSets.data() + rule * words;
+							for (size_t k = 0; k < words; ++k) {
+								target[k] |= leftSet[k];
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	return mf_Test(cell(0, n), m_startIndex);
+}
+
+uint32_t CYKRecognizer::mf_GetNonterminalIndex(Grammar::Symbol symbol) const
+{
+	return symbol < m_nonterminalIndexes.size() ? m_nonterminalIndexes[symbol] : kNoSymbol;
+}
+
+bool CYKRecognizer::mf_Test(const uint64_t* set, uint32_t index) const
+{
+	return (set[index / 64] >> (index % 64)) & 1;
+}
+
+void CYKRecognizer::mf_Set(uint64_t* set, uint32_t index) const
+{
+	set[index / 64] |= uint64_t(1) << (index % 64);
+}
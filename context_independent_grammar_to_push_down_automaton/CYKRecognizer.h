@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "Grammar.h"
+#include "InputSplitter.h"
+
+// Membership test over a grammar in Chomsky normal form. Every table cell is a bitset of nonterminals, and
+// the rules A ---> BC are grouped by B: for each B the bitset of every C it is paired with, and for each
+// pair (B, C) the bitset of the A's producing it. Combining two cells is then a few word-wide ANDs and ORs.
+// Cells are subwords of characters; a terminal named by several characters fills the cell of its whole
+// name, so every split of the word over the terminal names is tried.
+class CYKRecognizer
+{
+public:
+	CYKRecognizer(const Grammar& chomskyGrammar);
+
+public:
+	bool Accepts(std::string_view word) const;
+
+private:
+	uint32_t mf_GetNonterminalIndex(Grammar::Symbol symbol) const;
+	bool mf_Test(const uint64_t* set, uint32_t index) const;
+	void mf_Set(uint64_t* set, uint32_t index) const;
+
+private:
+	static constexpr uint32_t kNoSymbol = UINT32_MAX;
+
+private:
+	std::vector<Grammar::Symbol> m_nonterminals;
+	std::vector<uint32_t> m_nonterminalIndexes; // per symbol id
+	std::vector<uint32_t> m_terminalIndexes; // per symbol id
+	size_t m_wordsPerSet;
+	uint32_t m_startIndex;
+	bool m_acceptsEmptyWord;
+	InputSplitter m_inputSplitter;
+
+private:
+	std::vector<uint64_t> m_terminalSets; // per terminal, the nonterminals A with A ---> a
+	std::vector<uint64_t> m_pairedSymbols; // per B, the C's of the rules A ---> BC
+	std::vector<uint32_t> m_ruleOffsets; // rules of B are [m_ruleOffsets[B], m_ruleOffsets[B + 1])
+	std::vector<uint32_t> m_ruleRightSymbols; // C of every (B, C) pair
+	std::vector<uint64_t> m_ruleLeftSets; // per (B, C) pair, the A's of the rules A ---> BC
+};
@@ -0,0 +1,134 @@
+#include "CompactDerivationTree.h"
+#include <algorithm>
+
+CompactDerivationTree::CompactDerivationTree(Symbol startSymbol)
+	: m_nodes{ { startSymbol, kNoNode, kNoNode, kNoNode, kNoNode } }
+{
+	/* EMPTY */
+}
+
+bool CompactDerivationTree::operator==(const CompactDerivationTree& derivationTree) const
+{
+	// The pools may be filled in different orders, so the trees are walked side by side.
+	uint32_t thisNode = GetRoot();
+	uint32_t thatNode = derivationTree.GetRoot();
+	while (thisNode != kNoNode && thatNode != kNoNode) {
+		const Node& thisPart = m_nodes[thisNode];
+		const Node& thatPart = derivationTree.m_nodes[thatNode];
+		if (thisPart.symbol != thatPart.symbol
+			|| (thisPart.firstChild == kNoNode) != (thatPart.firstChild == kNoNode)
+			|| (thisPart.nextSibling == kNoNode) != (thatPart.nextSibling == kNoNode)) {
+			return false;
+		}
+		thisNode = GetNextInPreorder(thisNode);
+		thatNode = derivationTree.GetNextInPreorder(thatNode);
+	}
+	return thisNode == thatNode;
+}
+
+uint32_t CompactDerivationTree::AddChild(uint32_t parent, Symbol symbol)
+{
+	const uint32_t child = static_cast<uint32_t>(m_nodes.size());
+	m_nodes.push_back({ symbol, parent, kNoNode, kNoNode, kNoNode });
+	Node& parentNode = m_nodes[parent];
+	if (parentNode.lastChild == kNoNode) {
+		parentNode.firstChild = child;
+	}
+	else {
+		m_nodes[parentNode.lastChild].nextSibling = child;
+	}
+	parentNode.lastChild = child;
+	return child;
+}
+
+uint32_t CompactDerivationTree::GetRoot() const
+{
+	return Empty() ? kNoNode : 0;
+}
+
+const CompactDerivationTree::Node& CompactDerivationTree::GetNode(uint32_t node) const
+{
+	return m_nodes[node];
+}
+
+size_t CompactDerivationTree::GetNodesCount() const
+{
+	return m_nodes.size();
+}
+
+uint32_t CompactDerivationTree::GetNextInPreorder(uint32_t node) const
+{
+	if (m_nodes[node].firstChild != kNoNode) {
+		return m_nodes[node].firstChild;
+	}
+	for (; node != kNoNode; node = m_nodes[node].parent) {
+		if (m_nodes[node].nextSibling != kNoNode) {
+			return m_nodes[node].nextSibling;
+		}
+	}
+	return kNoNode;
+}
+
+std::vector<uint32_t> CompactDerivationTree::GetLeaves() const
+{
+	std::vector<uint32_t> result;
+	for (uint32_t node = GetRoot(); node != kNoNode; node = GetNextInPreorder(node)) {
+		if (m_nodes[node].firstChild == kNoNode) {
+			result.push_back(node);
+		}
+	}
+	return result;
+}
+
+CompactDerivationTree::SymbolString CompactDerivationTree::GetResult() const
+{
+	SymbolString result;
+	for (uint32_t node = GetRoot(); node != kNoNode; node = GetNextInPreorder(node)) {
+		if (m_nodes[node].firstChild == kNoNode) {
+			result += m_nodes[node].symbol;
+		}
+	}
+	return result;
+}
+
+std::string CompactDerivationTree::GetResult(const SymbolTable& symbolTable) const
+{
+	return symbolTable.ToString(GetResult());
+}
+
+unsigned int CompactDerivationTree::GetLongestPath() const
+{
+	// A child is always added after its parent, so one pass over the pool sees every parent's depth first.
+	std::vector<unsigned int> depths(m_nodes.size(), 0);
+	unsigned int maxLength = 0;
+	for (size_t node = 1; node < m_nodes.size(); ++node) {
+		depths[node] = depths[m_nodes[node].parent] + 1;
+		maxLength = std::max(maxLength, depths[node]);
+	}
+	return maxLength;
+}
+
+bool CompactDerivationTree::Empty() const
+{
+	return m_nodes.empty();
+}
+
+DerivationTree CompactDerivationTree::ToDerivationTree(const SymbolTable& symbolTable) const
+{
+	if (Empty()) {
+		return DerivationTree();
+	}
+	DerivationTree result(symbolTable.GetName(m_nodes[0].symbol));
+	std::vector<DerivationTree::Node*> treeNodes(m_nodes.size(), nullptr);
+	treeNodes[0] = result.GetRoot();
+	for (uint32_t node = GetNextInPreorder(0); node != kNoNode; node = GetNextInPreorder(node)) {
+		treeNodes[node] = new DerivationTree::Node(symbolTable.GetName(m_nodes[node].symbol));
+		treeNodes[m_nodes[node].parent]->AddChildren(treeNodes[node]);
+	}
+	return result;
+}
+
+void CompactDerivationTree::Clear()
+{
+	m_nodes.clear();
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DerivationTree.h"
+#include "SymbolTable.h"
+
+// Derivation tree kept in one contiguous node pool. Nodes refer to each other by 32-bit index, hold a symbol
+// id instead of its name and link their children as a first-child/next-sibling list, so copying or
+// destroying a tree is one vector copy or free and every walk follows the links without a stack.
+class CompactDerivationTree
+{
+public:
+	using Symbol = SymbolTable::Symbol;
+	using SymbolString = SymbolTable::SymbolString;
+
+public:
+	static constexpr uint32_t kNoNode = UINT32_MAX;
+
+public:
+	struct Node
+	{
+		Symbol symbol;
+		uint32_t parent;
+		uint32_t firstChild;
+		uint32_t lastChild; // appending a child stays O(1)
+		uint32_t nextSibling;
+	};
+
+public:
+	CompactDerivationTree() = default;
+	CompactDerivationTree(Symbol startSymbol);
+
+public:
+	bool operator ==(const CompactDerivationTree& derivationTree) const;
+
+public:
+	uint32_t AddChild(uint32_t parent, Symbol symbol); // after the children the node already has
+
+public:
+	uint32_t GetRoot() const; // kNoNode for an empty tree
+	const Node& GetNode(uint32_t node) const;
+	size_t GetNodesCount() const;
+	uint32_t GetNextInPreorder(uint32_t node) const; // kNoNode after the last node
+	std::vector<uint32_t> GetLeaves() const; // from left to right
+	SymbolString GetResult() const;
+	std::string GetResult(const SymbolTable& symbolTable) const;
+	unsigned int GetLongestPath() const;
+	bool Empty() const;
+
+public:
+	DerivationTree ToDerivationTree(const SymbolTable& symbolTable) const;
+
+public:
+	void Clear(); // keeps the pool allocated
+
+private:
+	std::vector<Node> m_nodes;
+};
@@ -1,6 +1,5 @@
 #include "DerivationTree.h"
-#include <stack>
-#include <queue>
+#include <utility>
 
 DerivationTree::DerivationTree(const std::string& startSymbol)
 	: m_root(new Node(startSymbol))
@@ -9,10 +8,17 @@ DerivationTree::DerivationTree(const std::string& startSymbol)
 }
 
 DerivationTree::DerivationTree(const DerivationTree& derivationTree)
+	: m_root(nullptr)
 {
 	*this = derivationTree;
 }
 
+DerivationTree::DerivationTree(DerivationTree&& derivationTree) noexcept
+	: m_root(derivationTree.m_root)
+{
+	derivationTree.m_root = nullptr;
+}
+
 DerivationTree::~DerivationTree()
 {
 	Clear();
@@ -20,99 +26,107 @@ DerivationTree::~DerivationTree()
 
 bool DerivationTree::operator==(const DerivationTree& derivationTree) const
 {
-	auto thisCross = GetCross();
-	auto thatCross = derivationTree.GetCross();
+	Range thisWalk = Preorder();
+	Range thatWalk = derivationTree.Preorder();
+	auto thisIt = thisWalk.begin();
+	auto thatIt = thatWalk.begin();
 
-	if (thisCross.size() != thatCross.size()) {
-		return false;
-	}
-
-	auto thisIt = thisCross.begin();
-	auto thatIt = thatCross.begin();
-
-	for (; thisIt != thisCross.end(); ++thisIt, ++thatIt) {
-		if ((*thisIt)->GetSymbols() != (*thatIt)->GetSymbols()) {
+	for (; thisIt != thisWalk.end() && thatIt != thatWalk.end(); ++thisIt, ++thatIt) {
+		if ((*thisIt)->GetSymbols() != (*thatIt)->GetSymbols() || (*thisIt)->GetChildrens().size() != (*thatIt)->GetChildrens().size()) {
 			return false;
 		}
 	}
-	return true;
+	return thisIt == thisWalk.end() && thatIt == thatWalk.end();
 }
 
 DerivationTree& DerivationTree::operator=(const DerivationTree& derivationTree)
 {
-	if (!Empty()) {
-		Clear();
+	if (this == &derivationTree) {
+		return *this;
+	}
+	Clear();
+	if (derivationTree.Empty()) {
+		return *this;
 	}
-	std::queue<Node*> queue1;
-	std::queue<Node*> queue2;
-	queue1.push(derivationTree.GetRoot());
-	m_root = new Node(derivationTree.GetRoot()->GetSymbols());
-
-	Node* iterator;
-	queue2.push(m_root);
-	while (!queue1.empty()) {
-		iterator = queue2.front();
-		for (Node* node : queue1.front()->GetChildrens()) {
-			queue1.push(node);
-			Node* auxNode = new Node(node->GetSymbols());
-			queue2.push(auxNode);
-			iterator->AddChildren(auxNode);
+	// The copy follows the source walk step by step: down to a first child, up to a parent, over to a sibling.
+	Node* const sourceRoot = derivationTree.GetRoot();
+	m_root = new Node(sourceRoot->GetSymbols());
+	Node* source = sourceRoot;
+	Node* copy = m_root;
+	while (true) {
+		if (source->HasChildrens()) {
+			source = source->GetChildrens().front();
+			Node* copiedNode = new Node(source->GetSymbols());
+			copy->AddChildren(copiedNode);
+			copy = copiedNode;
+			continue;
+		}
+		while (source != sourceRoot && !source->GetNextSibling()) {
+			source = source->GetParent();
+			copy = copy->GetParent();
+		}
+		if (source == sourceRoot) {
+			return *this;
 		}
-		queue1.pop();
-		queue2.pop();
+		source = source->GetNextSibling();
+		Node* copiedNode = new Node(source->GetSymbols());
+		copy->GetParent()->AddChildren(copiedNode);
+		copy = copiedNode;
 	}
-	return *this;
 }
 
-bool DerivationTree::VerifyIfVectorContainsNode(const std::vector<Node*> vector, Node* node) const
+DerivationTree& DerivationTree::operator=(DerivationTree&& derivationTree) noexcept
 {
-	for (Node* toBeCheckedNode : vector) {
-		if (toBeCheckedNode == node) {
-			return true;
-		}
+	if (this != &derivationTree) {
+		Clear();
+		m_root = derivationTree.m_root;
+		derivationTree.m_root = nullptr;
 	}
-	return false;
+	return *this;
+}
+
+DerivationTree::Range DerivationTree::Preorder() const
+{
+	return Range(m_root, Order::Preorder);
+}
+
+DerivationTree::Range DerivationTree::Postorder() const
+{
+	return Range(m_root, Order::Postorder);
+}
+
+DerivationTree::Range DerivationTree::Leaves() const
+{
+	return Range(m_root, Order::Leaves);
 }
 
 unsigned int DerivationTree::GetLongestPath() const
 {
-	int currentLenght = 0;
-	int maxLenght = 0;
+	unsigned int maxLenght = 0;
 	if (Empty()) {
 		return maxLenght;
 	}
-	std::vector<Node*> visitedNodes;
-	std::stack<Node*> stackOfNodes;
-	stackOfNodes.push(m_root);
-
-	while (!stackOfNodes.empty()) {
-		if (!stackOfNodes.top()->HasChildrens()) {
-			visitedNodes.push_back(stackOfNodes.top());
-			stackOfNodes.pop();
-			--currentLenght;
-			continue;
-		}
-
-		bool allChildrensAreEvaluated = true;
-		for (Node* node : stackOfNodes.top()->GetChildrens()) {
-			if (VerifyIfVectorContainsNode(visitedNodes, node)) {
-				continue;
-			}
-			allChildrensAreEvaluated = false;
-			stackOfNodes.push(node);
+	// Going down to a first child adds an edge, moving to a sibling keeps the depth, going up removes one.
+	unsigned int currentLenght = 0;
+	Node* node = m_root;
+	while (true) {
+		if (node->HasChildrens()) {
+			node = node->GetChildrens().front();
 			++currentLenght;
 			if (currentLenght > maxLenght) {
 				maxLenght = currentLenght;
 			}
-			break;
-		}
-		if (allChildrensAreEvaluated) {
-			visitedNodes.push_back(stackOfNodes.top());
-			stackOfNodes.pop();
 			continue;
 		}
+		while (node != m_root && !node->GetNextSibling()) {
+			node = node->GetParent();
+			--currentLenght;
+		}
+		if (node == m_root) {
+			return maxLenght;
+		}
+		node = node->GetNextSibling();
 	}
-	return maxLenght;
 }
 
 DerivationTree::Node* DerivationTree::GetRoot() const
@@ -123,33 +137,8 @@ DerivationTree::Node* DerivationTree::GetRoot() const
 std::vector<DerivationTree::Node*> DerivationTree::GetCross() const
 {
 	std::vector<Node*> result;
-	if (Empty()) {
-		return result;
-	}
-	std::stack<Node*> stackOfNodes;
-	stackOfNodes.push(m_root);
-
-	while (!stackOfNodes.empty()) {
-		if (!stackOfNodes.top()->HasChildrens()) {
-			result.push_back(stackOfNodes.top());
-			stackOfNodes.pop();
-			continue;
-		}
-
-		bool allChildrensAreEvaluated = true;
-		for (Node* node : stackOfNodes.top()->GetChildrens()) {
-			if (VerifyIfVectorContainsNode(result, node)) {
-				continue;
-			}
-			allChildrensAreEvaluated = false;
-			stackOfNodes.push(node);
-			break;
-		}
-		if (allChildrensAreEvaluated) {
-			result.push_back(stackOfNodes.top());
-			stackOfNodes.pop();
-			continue;
-		}
+	for (Node* node : Postorder()) {
+		result.push_back(node);
 	}
 	return result;
 }
@@ -157,10 +146,8 @@ std::vector<DerivationTree::Node*> DerivationTree::GetCross() const
 std::vector<DerivationTree::Node*> DerivationTree::GetLeaves() const
 {
 	std::vector<Node*> result;
-	for (Node* node : GetCross()) {
-		if (!node->HasChildrens()) {
-			result.push_back(node);
-		}
+	for (Node* node : Leaves()) {
+		result.push_back(node);
 	}
 	return result;
 }
@@ -168,7 +155,7 @@ std::vector<DerivationTree::Node*> DerivationTree::GetLeaves() const
 std::string DerivationTree::GetResult() const
 {
 	std::string result;
-	for (Node* node : GetLeaves()) {
+	for (Node* node : Leaves()) {
 		result += node->GetSymbols();
 	}
 	return result;
@@ -181,15 +168,35 @@ bool DerivationTree::Empty() const
 
 void DerivationTree::Clear()
 {
-	for (Node* node : GetCross()) {
-		delete node;
+	if (!Empty()) {
+		mf_DeleteSubtree(m_root);
 	}
 	m_root = nullptr;
 }
 
+DerivationTree::Node* DerivationTree::mf_GetLeftmostLeaf(Node* node)
+{
+	while (node->HasChildrens()) {
+		node = node->GetChildrens().front();
+	}
+	return node;
+}
+
+void DerivationTree::mf_DeleteSubtree(Node* node)
+{
+	// Post-order, each node deleted only after the walk has moved past it.
+	Range walk(node, Order::Postorder);
+	for (auto it = walk.begin(); it != walk.end();) {
+		Node* toBeDeletedNode = *it;
+		++it;
+		delete toBeDeletedNode;
+	}
+}
+
 DerivationTree::Node::Node(const std::string& symbols, Node* parent)
 	: m_symbols(symbols)
 	, m_parent(parent)
+	, m_indexInParent(0)
 {
 	/* EMPTY */
 }
@@ -214,6 +221,23 @@ bool DerivationTree::Node::HasChildrens() const
 	return !m_childrens.empty();
 }
 
+DerivationTree::Node* DerivationTree::Node::GetNextSibling() const
+{
+	if (!m_parent || m_indexInParent + 1 >= m_parent->m_childrens.size()) {
+		return nullptr;
+	}
+	return m_parent->m_childrens[m_indexInParent + 1];
+}
+
+unsigned int DerivationTree::Node::GetDepth() const
+{
+	unsigned int depth = 0;
+	for (const Node* node = m_parent; node; node = node->m_parent) {
+		++depth;
+	}
+	return depth;
+}
+
 void DerivationTree::Node::SetSymbols(const std::string& symbols)
 {
 	m_symbols = symbols;
@@ -226,27 +250,102 @@ void DerivationTree::Node::SetParent(Node* parent)
 
 void DerivationTree::Node::SetChildrens(const std::vector<Node*>& childrens)
 {
-	m_childrens = childrens;
+	m_childrens.clear();
+	for (Node* children : childrens) {
+		AddChildren(children);
+	}
 }
 
 void DerivationTree::Node::AddChildren(Node* children)
 {
 	children->SetParent(this);
+	children->m_indexInParent = m_childrens.size();
 	m_childrens.push_back(children);
 }
 
 void DerivationTree::Node::ClearChildrens()
 {
 	for (size_t i = 0; i < m_childrens.size(); ++i) {
-		delete m_childrens[i];
+		mf_DeleteSubtree(m_childrens[i]);
 	}
 	m_childrens.clear();
 }
 
+DerivationTree::Iterator::Iterator(Node* node, Node* root, Order order)
+	: m_node(node)
+	, m_root(root)
+	, m_order(order)
+{
+	/* EMPTY */
+}
+
+DerivationTree::Node* DerivationTree::Iterator::operator*() const
+{
+	return m_node;
+}
+
+DerivationTree::Iterator& DerivationTree::Iterator::operator++()
+{
+	if (m_order == Order::Preorder && m_node->HasChildrens()) {
+		m_node = m_node->GetChildrens().front();
+		return *this;
+	}
+	if (m_order == Order::Postorder) {
+		// After the last child comes its parent, after any other node the leftmost leaf of its next sibling.
+		Node* sibling = m_node == m_root ? nullptr : m_node->GetNextSibling();
+		m_node = m_node == m_root ? nullptr : sibling ? mf_GetLeftmostLeaf(sibling) : m_node->GetParent();
+		return *this;
+	}
+	while (m_node != m_root && !m_node->GetNextSibling()) {
+		m_node = m_node->GetParent();
+	}
+	m_node = m_node == m_root ? nullptr : m_node->GetNextSibling();
+	if (m_node && m_order == Order::Leaves) {
+		m_node = mf_GetLeftmostLeaf(m_node);
+	}
+	return *this;
+}
+
+DerivationTree::Iterator DerivationTree::Iterator::operator++(int)
+{
+	Iterator previous = *this;
+	++*this;
+	return previous;
+}
+
+bool DerivationTree::Iterator::operator==(const Iterator& iterator) const
+{
+	return m_node == iterator.m_node;
+}
+
+bool DerivationTree::Iterator::operator!=(const Iterator& iterator) const
+{
+	return m_node != iterator.m_node;
+}
+
+DerivationTree::Range::Range(Node* root, Order order)
+	: m_root(root)
+	, m_order(order)
+{
+	/* EMPTY */
+}
+
+DerivationTree::Iterator DerivationTree::Range::begin() const
+{
+	if (!m_root) {
+		return end();
+	}
+	return Iterator(m_order == Order::Preorder ? m_root : mf_GetLeftmostLeaf(m_root), m_root, m_order);
+}
+
+DerivationTree::Iterator DerivationTree::Range::end() const
+{
+	return Iterator(nullptr, m_root, m_order);
+}
+
 std::ostream& operator<<(std::ostream& out, const DerivationTree& derivationTree)
 {
-	auto cross = derivationTree.GetCross();
-	for (const auto& node : cross) {
+	for (const auto& node : derivationTree.Postorder()) {
 		out << node->GetSymbols() << ' ';
 	}
 	return out << '\n';
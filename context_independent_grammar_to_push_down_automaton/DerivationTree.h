@@ -1,4 +1,7 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -15,6 +18,8 @@ public:
 		Node* GetParent() const;
 		const std::vector<Node*>& GetChildrens() const;
 		bool HasChildrens() const;
+		Node* GetNextSibling() const; // nullptr for the last child
+		unsigned int GetDepth() const; // edges up to the root
 
 	public:
 		void SetSymbols(const std::string& symbols);
@@ -28,21 +33,71 @@ public:
 	private:
 		std::string m_symbols;
 		Node* m_parent;
+		size_t m_indexInParent;
 		std::vector<Node*>m_childrens;
 	};
+
+	enum class Order : uint8_t
+	{
+		Preorder,
+		Postorder, // the order of GetCross
+		Leaves // from left to right
+	};
+
+	// Walks a subtree by following the parent and sibling links, O(1) amortized per step and no allocation.
+	class Iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Node*;
+		using difference_type = std::ptrdiff_t;
+		using pointer = Node* const*;
+		using reference = Node*;
+
+	public:
+		Iterator(Node* node, Node* root, Order order);
+
+	public:
+		Node* operator *() const;
+		Iterator& operator ++();
+		Iterator operator ++(int);
+		bool operator ==(const Iterator& iterator) const;
+		bool operator !=(const Iterator& iterator) const;
+
+	private:
+		Node* m_node;
+		Node* m_root;
+		Order m_order;
+	};
+
+	class Range {
+	public:
+		Range(Node* root, Order order);
+
+	public:
+		Iterator begin() const;
+		Iterator end() const;
+
+	private:
+		Node* m_root;
+		Order m_order;
+	};
 public:
 	DerivationTree() = default;
 	DerivationTree(const std::string& startSymbol);
 	DerivationTree(const DerivationTree& derivationTree);
+	DerivationTree(DerivationTree&& derivationTree) noexcept;
 	~DerivationTree();
 
 public:
 	bool operator ==(const DerivationTree& derivationTree) const;
 	DerivationTree& operator =(const DerivationTree& derivationTree);
+	DerivationTree& operator =(DerivationTree&& derivationTree) noexcept;
 	friend std::ostream& operator <<(std::ostream& out, const DerivationTree& derivationTree);
 
-private:
-	bool VerifyIfVectorContainsNode(const std::vector<Node*> vector, Node* node) const;
+public:
+	Range Preorder() const;
+	Range Postorder() const;
+	Range Leaves() const;
 
 public:
 	unsigned int GetLongestPath() const;
@@ -55,6 +110,10 @@ public:
 public:
 	void Clear();
 
+private:
+	static Node* mf_GetLeftmostLeaf(Node* node);
+	static void mf_DeleteSubtree(Node* node);
+
 private:
 	Node* m_root = nullptr;
 };
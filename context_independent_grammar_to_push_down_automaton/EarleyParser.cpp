@@ -0,0 +1,235 @@
+#include "EarleyParser.h"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+EarleyParser::EarleyParser(const Grammar& grammar)
+	: m_symbolsCount(grammar.GetSymbolTable().Size())
+	, m_startSymbol(grammar.GetStartSymbol())
+	, m_inputSplitter(grammar)
+{
+	m_isNonterminal.assign(m_symbolsCount, false);
+	for (Grammar::Symbol symbol : grammar.GetNonterminalSymbols()) {
+		m_isNonterminal[symbol] = true;
+	}
+	m_rulesByLeft.resize(m_symbolsCount);
+
+	const auto& productions = grammar.GetProductions();
+	m_rules.reserve(productions.Size());
+	for (size_t i = 0; i < productions.Size(); ++i) {
+		const auto& [left, right] = productions[i];
+		if (left.size() != 1 || !mf_IsNonterminal(left[0])) {
+			throw "The grammar is not context independent.";
+		}
+		Rule rule;
+		rule.left = left[0];
+		rule.production = static_cast<uint32_t>(i);
+		for (Grammar::Symbol symbol : right) {
+			if (symbol != Grammar::kLambdaSymbol) {
+				rule.right.push_back(symbol);
+			}
+		}
+		m_rulesByLeft[rule.left].push_back(static_cast<uint32_t>(m_rules.size()));
+		m_rules.push_back(rule);
+	}
+
+	// Every (rule, dot) pair gets a distinct number, used to label intermediate nodes.
+	m_ruleDotOffsets.reserve(m_rules.size() + 1);
+	m_ruleDotOffsets.push_back(0);
+	for (const Rule& rule : m_rules) {
+		m_ruleDotOffsets.push_back(m_ruleDotOffsets.back() + static_cast<uint32_t>(rule.right.size()) + 1);
+	}
+}
+
+ParseForest EarleyParser::Parse(std::string_view word) const
+{
+	ParseForest forest;
+	Parse(word, forest);
+	return forest;
+}
+
+bool EarleyParser::Parse(std::string_view word, ParseForest& forest) const
+{
+	struct ItemSet
+	{
+		std::vector<Item> items;
+		std::unordered_set<Item, ItemHash> seen;
+		std::unordered_map<Grammar::Symbol, std::vector<uint32_t>> waiting; // items of the set by the nonterminal after the dot
+
+		void Add(const Item& item, Grammar::Symbol nextSymbol, bool complete) {
+			if (!seen.insert(item).second) {
+				return;
+			}
+			if (!complete) {
+				waiting[nextSymbol].push_back(static_cast<uint32_t>(items.size()));
+			}
+			items.push_back(item);
+		}
+	};
+
+	forest.Clear();
+	const size_t n = word.size();
+	std::vector<uint32_t> matchOffsets;
+	std::vector<InputSplitter::Match> matches;
+	m_inputSplitter.Split(word, matchOffsets, matches);
+	std::vector<ItemSet> sets(n + 1);
+	std::vector<Item> scanned;
+	std::vector<std::vector<std::pair<Item, uint32_t>>> pendingScans(n + 1); // per end position, an item and the terminal node it passes over
+	StampedHashMap createdNodes;
+	std::vector<uint32_t> nullableNodes(m_symbolsCount);
+	const std::vector<uint32_t> noWaitingItems;
+
+	// Items go to the set when the symbol after the dot is a nonterminal or missing, and to the list of
+	// items waiting for a terminal at this position otherwise.
+	auto addItem = [this, &sets, &scanned](const Item& item, size_t position) {
+		const Rule& rule = m_rules[item.rule];
+		if (mf_NextIsNonterminalOrEnd(item.rule, item.dot)) {
+			const bool complete = item.dot == rule.right.size();
+			sets[position].Add(item, complete ? SymbolTable::kNoSymbol : rule.right[item.dot], complete);
+		}
+		else {
+			scanned.push_back(item);
+		}
+	};
+
+	for (uint32_t rule : m_rulesByLeft[m_startSymbol]) {
+		addItem(Item{ rule, 0, 0, ParseForest::kNoNode }, 0);
+	}
+
+	for (size_t i = 0; i <= n; ++i) {
+		const uint32_t position = static_cast<uint32_t>(i);
+		std::fill(nullableNodes.begin(), nullableNodes.end(), ParseForest::kNoNode);
+
+		// Nodes created from here on end at i; they stay in createdNodes while the set is processed.
+		createdNodes.Clear();
+		for (const auto& [item, terminalNode] : pendingScans[i]) {
+			Item advanced{ item.rule, item.dot + 1, item.origin, item.node };
+			advanced.node = mf_MakeNode(advanced, position, terminalNode, forest, createdNodes);
+			addItem(advanced, i);
+		}
+		pendingScans[i].clear();
+
+		for (size_t r = 0; r < sets[i].items.size(); ++r) {
+			const Item item = sets[i].items[r];
+			const Rule& rule = m_rules[item.rule];
+
+			if (item.dot < rule.right.size()) {
+				const Grammar::Symbol next = rule.right[item.dot];
+				for (uint32_t predicted : m_rulesByLeft[next]) {
+					addItem(Item{ predicted, 0, position, ParseForest::kNoNode }, i);
+				}
+				// The nonterminal may already have been completed on the empty subword at this position.
+				const uint32_t nullableNode = nullableNodes[next];
+				if (nullableNode != ParseForest::kNoNode) {
+					Item advanced{ item.rule, item.dot + 1, item.origin, item.node };
+					advanced.node = mf_MakeNode(advanced, position, nullableNode, forest, createdNodes);
+					addItem(advanced, i);
+				}
+				continue;
+			}
+
+			uint32_t node = item.node;
+			if (node == ParseForest::kNoNode) {
+				const uint64_t key = (static_cast<uint64_t>(rule.left) << 32) | position;
+				node = createdNodes.Find(key);
+				if (node == StampedHashMap::kNotFound) {
+					node = forest.mf_AddNode(ParseForest::NodeKind::Symbol, rule.left, rule.production, item.dot, position, position);
+					createdNodes.Insert(key, node);
+				}
+				forest.mf_AddFamily(node, ParseForest::kNoNode, ParseForest::kNoNode);
+			}
+			if (item.origin == position) {
+				nullableNodes[rule.left] = node;
+			}
+			const auto waitingIt = sets[item.origin].waiting.find(rule.left);
+			const auto& waiting = waitingIt != sets[item.origin].waiting.end() ? waitingIt->second : noWaitingItems;
+			for (size_t w = 0; w < waiting.size(); ++w) {
+				const Item waitingItem = sets[item.origin].items[waiting[w]];
+				Item advanced{ waitingItem.rule, waitingItem.dot + 1, waitingItem.origin, waitingItem.node };
+				advanced.node = mf_MakeNode(advanced, position, node, forest, createdNodes);
+				addItem(advanced, i);
+			}
+		}
+
+		if (i == n) {
+			break;
+		}
+		// A terminal matched at i ends after its name, where the items waiting for it continue.
+		for (uint32_t m = matchOffsets[i]; m < matchOffsets[i + 1]; ++m) {
+			const InputSplitter::Match& match = matches[m];
+			uint32_t terminalNode = ParseForest::kNoNode;
+			for (const Item& item : scanned) {
+				if (m_rules[item.rule].right[item.dot] != match.symbol) {
+					continue;
+				}
+				if (terminalNode == ParseForest::kNoNode) {
+					terminalNode = forest.mf_AddNode(ParseForest::NodeKind::Terminal, match.symbol, 0, 0, position, position + match.length);
+				}
+				pendingScans[i + match.length].push_back({ item, terminalNode });
+			}
+		}
+		scanned.clear();
+	}
+
+	for (const Item& item : sets[n].items) {
+		const Rule& rule = m_rules[item.rule];
+		if (rule.left == m_startSymbol && item.origin == 0 && item.dot == rule.right.size()) {
+			// A lambda production on the empty word keeps no node in its item; its node was created on completion.
+			forest.m_root = item.node != ParseForest::kNoNode
+				? item.node
+				: createdNodes.Find(static_cast<uint64_t>(m_startSymbol) << 32);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool EarleyParser::mf_IsNonterminal(Grammar::Symbol symbol) const
+{
+	return symbol < m_isNonterminal.size() && m_isNonterminal[symbol];
+}
+
+bool EarleyParser::mf_NextIsNonterminalOrEnd(uint32_t rule, uint32_t dot) const
+{
+	const Grammar::SymbolString& right = m_rules[rule].right;
+	return dot == right.size() || mf_IsNonterminal(right[dot]);
+}
+
+uint32_t EarleyParser::mf_MakeNode(const Item& advanced, uint32_t position, uint32_t child, ParseForest& forest, StampedHashMap& createdNodes) const
+{
+	// advanced.node is still the node of the symbols before the one just passed over.
+	const Rule& rule = m_rules[advanced.rule];
+	const bool complete = advanced.dot == rule.right.size();
+	if (advanced.dot == 1 && !complete) {
+		return child;
+	}
+
+	// Nodes created at this position all end here, so the label only needs the left extent.
+	const uint64_t label = complete
+		? static_cast<uint64_t>(rule.left)
+		: m_symbolsCount + static_cast<uint64_t>(m_ruleDotOffsets[advanced.rule] + advanced.dot);
+	const uint64_t key = (label << 32) | advanced.origin;
+	uint32_t node = createdNodes.Find(key);
+	if (node == StampedHashMap::kNotFound) {
+		node = complete
+			? forest.mf_AddNode(ParseForest::NodeKind::Symbol, rule.left, rule.production, advanced.dot, advanced.origin, position)
+			: forest.mf_AddNode(ParseForest::NodeKind::Intermediate, rule.left, rule.production, advanced.dot, advanced.origin, position);
+		createdNodes.Insert(key, node);
+	}
+	forest.mf_AddFamily(node, advanced.node, child);
+	return node;
+}
+
+bool EarleyParser::Item::operator==(const Item& item) const
+{
+	return rule == item.rule && dot == item.dot && origin == item.origin && node == item.node;
+}
+
+size_t EarleyParser::ItemHash::operator()(const Item& item) const
+{
+	uint64_t hash = item.rule;
+	hash = hash * 0x9e3779b97f4a7c15ULL + item.dot;
+	hash = hash * 0x9e3779b97f4a7c15ULL + item.origin;
+	hash = hash * 0x9e3779b97f4a7c15ULL + item.node;
+	return static_cast<size_t>(hash ^ (hash >> 29));
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Grammar.h"
+#include "InputSplitter.h"
+#include "ParseForest.h"
+#include "StampedHashMap.h"
+
+// General context independent parser working directly on the productions of a grammar, without any
+// normalization: lambda productions, renames, left recursion and ambiguity are all allowed. It builds the
+// shared packed parse forest of every derivation while recognising (Scott's SPPF-style Earley parser).
+// Positions are characters, so terminals named by several characters span several of them, and every
+// split of the word over the terminal names is parsed at once.
+class EarleyParser
+{
+public:
+	EarleyParser(const Grammar& grammar);
+
+public:
+	ParseForest Parse(std::string_view word) const;
+	bool Parse(std::string_view word, ParseForest& forest) const; // clears forest and reuses its pools
+
+private:
+	struct Rule
+	{
+		Grammar::Symbol left;
+		Grammar::SymbolString right; // lambda symbols removed
+		uint32_t production;
+	};
+
+	struct Item
+	{
+		uint32_t rule;
+		uint32_t dot;
+		uint32_t origin;
+		uint32_t node;
+
+		bool operator ==(const Item& item) const;
+	};
+
+	struct ItemHash
+	{
+		size_t operator ()(const Item& item) const;
+	};
+
+private:
+	bool mf_IsNonterminal(Grammar::Symbol symbol) const;
+	bool mf_NextIsNonterminalOrEnd(uint32_t rule, uint32_t dot) const;
+	uint32_t mf_MakeNode(const Item& advanced, uint32_t position, uint32_t child, ParseForest& forest, StampedHashMap& createdNodes) const;
+
+private:
+	std::vector<Rule> m_rules;
+	std::vector<std::vector<uint32_t>> m_rulesByLeft; // per symbol id
+	std::vector<uint32_t> m_ruleDotOffsets;
+	std::vector<bool> m_isNonterminal;
+	size_t m_symbolsCount;
+	Grammar::Symbol m_startSymbol;
+	InputSplitter m_inputSplitter;
+};
@@ -1,14 +1,29 @@
 #include "Grammar.h"
+#include "BinaryFormat.h"
 #include "DerivationTree.h"
+#include "GrammarScanner.h"
+#include "LanguageEnumerator.h"
+#include "MappedFile.h"
+#include "PushDownAutomaton.h"
+#include "SententialForm.h"
+#include "WordSampler.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <functional>
+#include <array>
+#include <iterator>
 #include <set>
+#include <utility>
 
 Grammar::Grammar()
-	: m_startSymbol('\0')
+	: m_startSymbol(SymbolTable::kNoSymbol)
+	, m_productionIndexesAreBuilt(false)
 	, m_type(Type::Invalid)
 {
-	/* EMPTY */
+	m_symbolTable.Intern(std::string(1, kLambda));
 }
 Grammar::Grammar(std::ifstream& in)
+	: Grammar()
 {
 	ReadFile(in);
 }
@@ -16,19 +31,62 @@ Grammar::Grammar(const Grammar& grammar)
 {
 	*this = grammar;
 }
+Grammar::Grammar(Grammar&& grammar) noexcept
+{
+	*this = std::move(grammar);
+}
 
 Grammar& Grammar::operator=(const Grammar& grammar)
 {
+	m_symbolTable = grammar.m_symbolTable;
 	m_nonterminalSymbols = grammar.m_nonterminalSymbols;
 	m_terminalSymbols = grammar.m_terminalSymbols;
+	m_isNonterminal = grammar.m_isNonterminal;
+	m_isTerminal = grammar.m_isTerminal;
+	// Indexes still being built by another reader are not copied; this grammar builds its own.
+	if (grammar.m_productionIndexesAreBuilt.load(std::memory_order_acquire)) {
+		m_productionsByLeft = grammar.m_productionsByLeft;
+		m_productionsByRight = grammar.m_productionsByRight;
+		m_productionIndexesAreBuilt.store(true, std::memory_order_release);
+	}
+	else {
+		mf_InvalidateProductionIndexes();
+	}
+	m_savedProductionIndexes = grammar.m_savedProductionIndexes;
+	m_verificationErrors = grammar.m_verificationErrors;
 	m_startSymbol = grammar.m_startSymbol;
 	m_productions = grammar.m_productions;
 	m_type = grammar.m_type;
 	return *this;
 }
+Grammar& Grammar::operator=(Grammar&& grammar) noexcept
+{
+	if (this == &grammar) {
+		return *this;
+	}
+	m_symbolTable = std::move(grammar.m_symbolTable);
+	m_nonterminalSymbols = std::move(grammar.m_nonterminalSymbols);
+	m_terminalSymbols = std::move(grammar.m_terminalSymbols);
+	m_isNonterminal = std::move(grammar.m_isNonterminal);
+	m_isTerminal = std::move(grammar.m_isTerminal);
+	m_productionsByLeft = std::move(grammar.m_productionsByLeft);
+	m_productionsByRight = std::move(grammar.m_productionsByRight);
+	m_productionIndexesAreBuilt.store(grammar.m_productionIndexesAreBuilt.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	m_savedProductionIndexes = std::move(grammar.m_savedProductionIndexes);
+	m_verificationErrors = std::move(grammar.m_verificationErrors);
+	m_startSymbol = grammar.m_startSymbol;
+	m_productions = std::move(grammar.m_productions);
+	m_type = grammar.m_type;
+	grammar.m_startSymbol = SymbolTable::kNoSymbol;
+	grammar.mf_InvalidateProductionIndexes();
+	grammar.m_type = Type::Invalid;
+	return *this;
+}
 bool Grammar::operator==(const Grammar& grammar) const
 {
 	return
+		m_symbolTable == grammar.m_symbolTable
+		&&
 		m_nonterminalSymbols == grammar.m_nonterminalSymbols
 		&&
 		m_terminalSymbols == grammar.m_terminalSymbols
@@ -41,22 +99,47 @@ const Grammar::Type& Grammar::GetType() const
 {
 	return m_type;
 }
+const std::vector<Grammar::Symbol>& Grammar::GetNonterminalSymbols() const
+{
+	return m_nonterminalSymbols;
+}
+const std::vector<Grammar::Symbol>& Grammar::GetTerminalSymbols() const
+{
+	return m_terminalSymbols;
+}
+Grammar::Symbol Grammar::GetStartSymbol() const
+{
+	return m_startSymbol;
+}
+const ProductionList& Grammar::GetProductions() const
+{
+	return m_productions;
+}
+const SymbolTable& Grammar::GetSymbolTable() const
+{
+	return m_symbolTable;
+}
+const std::vector<Grammar::VerificationError>& Grammar::GetVerificationErrors() const
+{
+	return m_verificationErrors;
+}
 std::ostream& operator<<(std::ostream& os, const Grammar& grammar)
 {
 	const auto& vn = grammar.m_nonterminalSymbols;
 	const auto& vt = grammar.m_terminalSymbols;
 	const auto& p = grammar.m_productions;
-	std::vector<char>::const_iterator beforeEnd;
+	const auto& table = grammar.m_symbolTable;
+	std::vector<Grammar::Symbol>::const_iterator beforeEnd;
 
 	os << "Vn: { ";
 	beforeEnd = vn.size() > 1 ? vn.end() - 1 : vn.begin();
 	for (auto it = vn.begin(); it != beforeEnd; ++it)
 	{
-		os << *it << ", ";
+		os << table.GetName(*it) << ", ";
 	}
 	if (!vn.empty())
 	{
-		os << *beforeEnd << ' ';
+		os << table.GetName(*beforeEnd) << ' ';
 	}
 	os << '}' << '\n';
 
@@ -64,22 +147,22 @@ std::ostream& operator<<(std::ostream& os, const Grammar& grammar)
 	beforeEnd = vt.size() > 1 ? vt.end() - 1 : vt.begin();
 	for (auto it = vt.begin(); it != beforeEnd; ++it)
 	{
-		os << *it << ", ";
+		os << table.GetName(*it) << ", ";
 	}
 	if (!vt.empty())
 	{
-		os << *beforeEnd << ' ';
+		os << table.GetName(*beforeEnd) << ' ';
 	}
 	os << '}' << '\n';
 
-	os << "Start symbol: " << grammar.m_startSymbol << '\n';
+	os << "Start symbol: " << (grammar.m_startSymbol != SymbolTable::kNoSymbol ? table.GetName(grammar.m_startSymbol) : std::string()) << '\n';
 
 	os << "Productions:" << '\n';
-	for (size_t i = 0; i < p.size(); ++i)
+	for (size_t i = 0; i < p.Size(); ++i)
 	{
-		os << p[i].first;
+		os << table.ToString(p[i].first);
 		os << " ---> ";
-		os << p[i].second;
+		os << table.ToString(p[i].second);
 		os << '\n';
 	}
 
@@ -98,107 +181,346 @@ std::ostream& operator<<(std::ostream& os, const Grammar& grammar)
 
 void Grammar::ReadFile(std::ifstream& in)
 {
-	int vnSize;
-	int vtSize;
-	int productionsSize;
-	char symbol;
-	Production production;
+	const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	ReadText(text);
+}
+void Grammar::ReadText(std::string_view text)
+{
+	// The nonterminals, the terminals, the start symbol and the productions, each list after its count.
+	// A symbol is one character; a production is two tokens, its left and its right part.
+	// A text that starts with '<' is read as BNF instead, see mf_ReadBnf.
+	*this = Grammar();
+	GrammarScanner scanner(text);
+	if (scanner.Peek() == '<') {
+		mf_ReadBnf(scanner);
+		mf_InvalidateProductionIndexes();
+		Verify();
+		return;
+	}
+	// A character is interned, and checked to be a terminal, a nonterminal or lambda, the first time it is seen.
+	std::array<Symbol, 256> symbolOfCharacter;
+	symbolOfCharacter.fill(SymbolTable::kNoSymbol);
+	auto isKnown = [this](Symbol symbol) {
+		return symbol == kLambdaSymbol || mf_IsNonterminal(symbol) || mf_IsTerminal(symbol);
+	};
+	bool symbolsAreKnown = true;
+	auto intern = [this, &symbolOfCharacter, &isKnown, &symbolsAreKnown](char character) {
+		Symbol& symbol = symbolOfCharacter[static_cast<unsigned char>(character)];
+		if (symbol == SymbolTable::kNoSymbol) {
+			symbol = m_symbolTable.Intern(std::string_view(&character, 1));
+			symbolsAreKnown = symbolsAreKnown && isKnown(symbol);
+		}
+		return symbol;
+	};
+	// Counts only size reservations up to what the text can hold, whatever they claim.
+	auto reserved = [&text](uint64_t count) {
+		return static_cast<size_t>(std::min<uint64_t>(count, text.size() / 2 + 1));
+	};
 
-	in >> vnSize;
-	m_nonterminalSymbols.reserve(vnSize);
-	for (int i = 0; i < vnSize; ++i)
-	{
-		in >> symbol;
-		m_nonterminalSymbols.push_back(symbol);
+	const uint64_t vnSize = scanner.ReadCount();
+	m_nonterminalSymbols.reserve(reserved(vnSize));
+	for (uint64_t i = 0; i < vnSize; ++i) {
+		m_nonterminalSymbols.push_back(intern(scanner.ReadCharacter()));
 	}
 
-	in >> vtSize;
-	m_terminalSymbols.reserve(vtSize);
-	for (int i = 0; i < vtSize; ++i)
-	{
-		in >> symbol;
-		m_terminalSymbols.push_back(symbol);
+	const uint64_t vtSize = scanner.ReadCount();
+	m_terminalSymbols.reserve(reserved(vtSize));
+	for (uint64_t i = 0; i < vtSize; ++i) {
+		m_terminalSymbols.push_back(intern(scanner.ReadCharacter()));
 	}
+	mf_UpdateSymbolSets();
 
-	in >> m_startSymbol;
+	m_startSymbol = intern(scanner.ReadCharacter());
+	symbolsAreKnown = std::all_of(symbolOfCharacter.begin(), symbolOfCharacter.end(), [&isKnown](Symbol symbol) {
+		return symbol == SymbolTable::kNoSymbol || isKnown(symbol);
+	});
 
-	in >> productionsSize;
-	m_productions.reserve(productionsSize);
-	for (int i = 0; i < productionsSize; ++i)
-	{
-		in >> production.first;
-		in >> production.second;
-		m_productions.push_back(production);
+	// The checks of Verify, with each production verified as it is read. Both parts are interned into one
+	// reused buffer and appended from there to the flat production store, which is allocated once: there is
+	// at most one symbol per character of the text.
+	mf_VerifyIntersection();
+	mf_VerifyStartSymbol();
+	Type type = Type::Regular;
+	const uint64_t productionsSize = scanner.ReadCount();
+	m_productions.Reserve(reserved(productionsSize), text.size());
+	SymbolString parts;
+	for (uint64_t i = 0; i < productionsSize; ++i) {
+		const std::string_view left = scanner.ReadToken();
+		const std::string_view right = scanner.ReadToken();
+		parts.resize(left.size() + right.size());
+		std::transform(left.begin(), left.end(), parts.begin(), intern);
+		std::transform(right.begin(), right.end(), parts.begin() + left.size(), intern);
+		const SymbolStringView symbols(parts);
+		const size_t productionIndex = m_productions.Add(symbols.substr(0, left.size()), symbols.substr(left.size()));
+		// A ---> beta over known symbols is valid and at most context independent, so once the grammar is not
+		// regular such a production cannot change the result.
+		if (type == Type::Regular || !symbolsAreKnown || left.size() != 1 || !mf_IsNonterminal(parts[0])) {
+			type = std::max(type, mf_VerifyProduction(productionIndex, symbolsAreKnown));
+		}
 	}
+	if (!scanner.AtEnd()) {
+		scanner.Fail("The text continues after the last production.");
+	}
+	mf_InvalidateProductionIndexes();
+	m_type = m_verificationErrors.empty() ? type : Type::Invalid;
+}
+void Grammar::mf_ReadBnf(GrammarScanner& scanner)
+{
+	// <Name> ::= alternative | alternative ..., where an alternative is a sequence of <Nonterminal> and
+	// "terminal" symbols and "" (or nothing) is lambda. Names may have any length; the start symbol is
+	// the left part of the first rule. A rule ends where the next <Name> ::= begins.
+	std::vector<uint8_t> listed; // per symbol id, 1 if in m_nonterminalSymbols, 2 if in m_terminalSymbols
+	auto intern = [this, &scanner, &listed](std::string_view name, bool nonterminal) {
+		const Symbol symbol = m_symbolTable.Intern(name);
+		if (symbol == kLambdaSymbol) {
+			scanner.Fail("The name of lambda cannot be used as a symbol.");
+		}
+		listed.resize(m_symbolTable.Size(), 0);
+		const uint8_t flag = nonterminal ? 1 : 2;
+		if (!(listed[symbol] & flag)) {
+			listed[symbol] |= flag;
+			(nonterminal ? m_nonterminalSymbols : m_terminalSymbols).push_back(symbol);
+		}
+		return symbol;
+	};
+	auto readNonterminal = [&scanner, &intern]() {
+		const std::string_view name = scanner.ReadDelimited('<', '>');
+		if (name.empty()) {
+			scanner.Fail("A nonterminal name cannot be empty.");
+		}
+		return intern(name, true);
+	};
 
-	Verify();
+	Symbol left = readNonterminal();
+	if (!scanner.Accept("::=")) {
+		scanner.Fail("'::=' was expected.");
+	}
+	m_startSymbol = left;
+	SymbolString right;
+	auto addProduction = [this, &left, &right]() {
+		m_productions.Add(SymbolString(1, left), right.empty() ? SymbolString(1, kLambdaSymbol) : right);
+		right.clear();
+	};
+	while (true) {
+		const char next = scanner.Peek();
+		if (next == '"') {
+			const std::string_view name = scanner.ReadDelimited('"', '"');
+			if (!name.empty()) {
+				right.push_back(intern(name, false));
+			}
+		}
+		else if (next == '<') {
+			const Symbol symbol = readNonterminal();
+			if (scanner.Accept("::=")) {
+				addProduction();
+				left = symbol;
+			}
+			else {
+				right.push_back(symbol);
+			}
+		}
+		else if (next == '|') {
+			scanner.Accept("|");
+			addProduction();
+		}
+		else if (next == '\0') {
+			addProduction();
+			break;
+		}
+		else {
+			scanner.Fail("A <nonterminal>, a \"terminal\" or '|' was expected.");
+		}
+	}
+	mf_UpdateSymbolSets();
+}
+void Grammar::ReadMappedFile(const std::string& path)
+{
+	const MappedFile file(path);
+	ReadText(std::string_view(reinterpret_cast<const char*>(file.GetData()), file.GetSize()));
+}
+void Grammar::SaveBinary(std::ostream& out) const
+{
+	std::vector<std::string> names;
+	names.reserve(m_symbolTable.Size());
+	for (Symbol symbol = 0; symbol < m_symbolTable.Size(); ++symbol) {
+		names.push_back(m_symbolTable.GetName(symbol));
+	}
+	// The production indexes are saved too, with the productions of symbol s at [offsets[s], offsets[s + 1])
+	// of the entries, in increasing order. Counted first, then placed, as a counting sort.
+	auto writeIndex = [this](BinaryFormat::Writer& writer, bool leftPart) {
+		std::vector<uint32_t> offsets(m_symbolTable.Size() + 1, 0);
+		for (const auto& production : m_productions) {
+			for (Symbol symbol : leftPart ? production.first : production.second) {
+				++offsets[symbol + 1];
+			}
+		}
+		for (size_t i = 1; i < offsets.size(); ++i) {
+			offsets[i] += offsets[i - 1];
+		}
+		std::vector<uint32_t> entries(offsets.back());
+		std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < m_productions.Size(); ++i) {
+			for (Symbol symbol : leftPart ? m_productions[i].first : m_productions[i].second) {
+				entries[cursors[symbol]++] = static_cast<uint32_t>(i);
+			}
+		}
+		writer.WriteArray(std::span<const uint32_t>(offsets));
+		writer.WriteArray(std::span<const uint32_t>(entries));
+	};
 
-	in.close();
+	BinaryFormat::Writer writer(out, BinaryFormat::Kind::Grammar);
+	writer.WriteStrings(names);
+	writer.Write(static_cast<uint32_t>(m_startSymbol));
+	writer.Write(static_cast<uint32_t>(m_type));
+	writer.WriteArray(std::span<const Symbol>(m_nonterminalSymbols));
+	writer.WriteArray(std::span<const Symbol>(m_terminalSymbols));
+	writer.WriteArray(m_productions.GetSymbols());
+	writer.WriteArray(m_productions.GetBounds());
+	writeIndex(writer, true);
+	writeIndex(writer, false);
 }
-void Grammar::Verify()
+void Grammar::SaveBinary(const std::string& path) const
 {
-	if (!mf_VerifyIntersection())
-	{
-		m_type = Type::Invalid;
-		return;
+	std::ofstream out(path, std::ios::binary);
+	if (!out) {
+		throw "The file could not be opened.";
 	}
-	if (!mf_VerifyStartSymbol())
-	{
-		m_type = Type::Invalid;
-		return;
-	}
-	if (!mf_VerifyAtLeastOneNonterminalInProductionLeft())
-	{
-		m_type = Type::Invalid;
-		return;
-	}
-	if (!mf_VerifyProductions())
-	{
-		m_type = Type::Invalid;
-		return;
-	}
-	for (const auto& production : m_productions) {
-		if (production.first.size() > 1) {
-			m_type = Type::ContextDependent;
-			return;
+	SaveBinary(out);
+}
+void Grammar::LoadBinary(std::span<const uint8_t> bytes)
+{
+	mf_LoadBinary(bytes, nullptr);
+}
+void Grammar::LoadBinary(const std::string& path)
+{
+	std::shared_ptr<const MappedFile> image = std::make_shared<MappedFile>(path);
+	mf_LoadBinary(image->GetBytes(), image);
+}
+void Grammar::mf_LoadBinary(std::span<const uint8_t> bytes, std::shared_ptr<const MappedFile> image)
+{
+	BinaryFormat::Reader reader(bytes, BinaryFormat::Kind::Grammar);
+	const std::vector<std::string> names = reader.ReadStrings();
+	const Symbol startSymbol = reader.Read<uint32_t>();
+	const uint32_t type = reader.Read<uint32_t>();
+	const std::span<const Symbol> nonterminals = reader.ReadArray<Symbol>();
+	const std::span<const Symbol> terminals = reader.ReadArray<Symbol>();
+	const std::span<const Symbol> symbols = reader.ReadArray<Symbol>();
+	const std::span<const ProductionList::Bounds> bounds = reader.ReadArray<ProductionList::Bounds>();
+	const std::span<const uint32_t> leftOffsets = reader.ReadArray<uint32_t>();
+	const std::span<const uint32_t> leftEntries = reader.ReadArray<uint32_t>();
+	const std::span<const uint32_t> rightOffsets = reader.ReadArray<uint32_t>();
+	const std::span<const uint32_t> rightEntries = reader.ReadArray<uint32_t>();
+
+	auto isSymbol = [&names](Symbol symbol) {
+		return symbol < names.size();
+	};
+	auto isWithin = [&symbols](uint32_t begin, uint32_t length) {
+		return begin <= symbols.size() && length <= symbols.size() - begin;
+	};
+	if (type > static_cast<uint32_t>(Type::Invalid) || (startSymbol != SymbolTable::kNoSymbol && !isSymbol(startSymbol))
+		|| !std::all_of(nonterminals.begin(), nonterminals.end(), isSymbol) || !std::all_of(terminals.begin(), terminals.end(), isSymbol)
+		|| !std::all_of(symbols.begin(), symbols.end(), isSymbol) || bounds.size() > UINT32_MAX
+		|| !std::all_of(bounds.begin(), bounds.end(), [&isWithin](const ProductionList::Bounds& production) {
+			return isWithin(production.leftBegin, production.leftLength) && isWithin(production.rightBegin, production.rightLength);
+		})) {
+		throw "The binary image is not valid.";
+	}
+	// The indexes must be exactly the ones the productions give, since edits rely on them: walking the
+	// productions in order meets every entry of a symbol in its place, and all of them.
+	auto isIndex = [&names, &symbols, &bounds](std::span<const uint32_t> offsets, std::span<const uint32_t> entries, bool leftPart) {
+		if (offsets.size() != names.size() + 1 || offsets.front() != 0 || offsets.back() != entries.size()
+			|| !std::is_sorted(offsets.begin(), offsets.end())) {
+			return false;
 		}
-		switch (production.second.size())
-		{
-		case 1: {
-			if (mf_ConvertVectorOfCharsToUset(m_nonterminalSymbols).count(production.second[0])) {
-				m_type = Type::ContextIndependent;
-				return;
+		std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+		for (uint32_t i = 0; i < bounds.size(); ++i) {
+			const uint32_t begin = leftPart ? bounds[i].leftBegin : bounds[i].rightBegin;
+			const uint32_t length = leftPart ? bounds[i].leftLength : bounds[i].rightLength;
+			for (uint32_t j = begin; j < begin + length; ++j) {
+				uint32_t& cursor = cursors[symbols[j]];
+				if (cursor == offsets[symbols[j] + 1] || entries[cursor] != i) {
+					return false;
+				}
+				++cursor;
 			}
-			break;
 		}
-
-		case 2: {
-			std::unordered_set<char> nSet = mf_ConvertVectorOfCharsToUset(m_nonterminalSymbols);
-			std::unordered_set<char> tSet = mf_ConvertVectorOfCharsToUset(m_terminalSymbols);
-			if (nSet.count(production.second[0]) || tSet.count(production.second[1])) {
-				m_type = Type::ContextIndependent;
-				return;
+		for (size_t symbol = 0; symbol < cursors.size(); ++symbol) {
+			if (cursors[symbol] != offsets[symbol + 1]) {
+				return false;
 			}
-			break;
 		}
+		return true;
+	};
+	if (!isIndex(leftOffsets, leftEntries, true) || !isIndex(rightOffsets, rightEntries, false)) {
+		throw "The binary image is not valid.";
+	}
 
-		default: {
-			m_type = Type::ContextIndependent;
-			return;
-		}
+	SymbolTable symbolTable;
+	for (const std::string& name : names) {
+		if (symbolTable.Find(name) != SymbolTable::kNoSymbol) {
+			throw "The binary image is not valid.";
 		}
+		symbolTable.Intern(name);
+	}
+	m_symbolTable = std::move(symbolTable);
+	m_nonterminalSymbols.assign(nonterminals.begin(), nonterminals.end());
+	m_terminalSymbols.assign(terminals.begin(), terminals.end());
+	mf_UpdateSymbolSets();
+	m_startSymbol = startSymbol;
+	m_type = static_cast<Type>(type);
+	m_verificationErrors.clear();
+	// The productions and their indexes are taken as saved, nothing is built per production. Those of a
+	// mapped image are read in place; bytes the caller owns are gone after the call, so theirs are copied.
+	if (image) {
+		m_productions.Assign(symbols, bounds, image);
+	}
+	else {
+		m_productions.Assign(symbols, bounds);
+	}
+	mf_InvalidateProductionIndexes();
+	m_savedProductionIndexes = { image, leftOffsets, leftEntries, rightOffsets, rightEntries };
+	if (!image) {
+		mf_EnsureProductionIndexes();
+		m_savedProductionIndexes = SavedProductionIndexes();
+	}
+}
+void Grammar::Verify()
+{
+	// One pass over the productions: each one is checked and typed, and the grammar gets the most general
+	// type among them. Every failed check is recorded, so the pass never stops at the first one.
+	// The symbols are checked once over the flat store; only if one is unknown is each production checked.
+	m_verificationErrors.clear();
+	mf_VerifyIntersection();
+	mf_VerifyStartSymbol();
+
+	const bool symbolsAreKnown = mf_AllSymbolsAreKnown();
+	Type type = Type::Regular;
+	for (size_t i = 0; i < m_productions.Size(); ++i) {
+		type = std::max(type, mf_VerifyProduction(i, symbolsAreKnown));
 	}
-	m_type = Type::Regular;
+	m_type = m_verificationErrors.empty() ? type : Type::Invalid;
 }
 
 std::string Grammar::GenerateWord() const
+{
+	RandomEngine engine;
+	return GenerateWord(engine);
+}
+std::string Grammar::GenerateWord(RandomEngine& engine) const
 {
 	if (m_type == Type::Invalid)
 	{
 		throw "The grammar hasn't passed all the tests.";
 	}
+	if (m_type == Type::ContextIndependent || m_type == Type::Regular)
+	{
+		SententialForm form = mf_CreateSententialForm();
+		std::string word;
+		mf_GenerateContextIndependentWord(engine, form, word);
+		return word;
+	}
 
-	std::string currentWord;
+	SymbolString currentWord;
 	currentWord.push_back(m_startSymbol);
 
 	std::vector<std::pair<int, std::vector<int>>> aplicableProductionsInCurrentWord;
@@ -207,12 +529,12 @@ std::string Grammar::GenerateWord() const
 
 	while (true)
 	{
-		for (int i = 0; i < m_productions.size(); ++i)
+		for (size_t i = 0; i < m_productions.Size(); ++i)
 		{
 			placesInCurrentWordWhereItCanBeApplied = mf_GetSubstrPositionsInString(m_productions[i].first, currentWord);
 			if (!placesInCurrentWordWhereItCanBeApplied.empty())
 			{
-				productionIndex = i;
+				productionIndex = static_cast<int>(i);
 				aplicableProductionsInCurrentWord.push_back(pair);
 			}
 		}
@@ -221,35 +543,219 @@ std::string Grammar::GenerateWord() const
 			break;
 		}
 		const size_t& sizeOfApplicableProductions = aplicableProductionsInCurrentWord.size();
-		size_t randomApplicableProduction = mf_GetRandom(0, sizeOfApplicableProductions - 1);
+		size_t randomApplicableProduction = mf_GetRandom(0, sizeOfApplicableProductions - 1, engine);
 
 		int productionIndex = aplicableProductionsInCurrentWord[randomApplicableProduction].first;
 
 		const size_t& sizeOfPlacesWhereThisProductionCanBeApplied = aplicableProductionsInCurrentWord[randomApplicableProduction].second.size();
-		size_t randomPositionInVectorOfPlaces = mf_GetRandom(0, sizeOfPlacesWhereThisProductionCanBeApplied - 1);
+		size_t randomPositionInVectorOfPlaces = mf_GetRandom(0, sizeOfPlacesWhereThisProductionCanBeApplied - 1, engine);
 
 		int positionInString = aplicableProductionsInCurrentWord[randomApplicableProduction].second[randomPositionInVectorOfPlaces];
 
 		mf_ApplyProductionOnString(productionIndex, positionInString, currentWord);
 		aplicableProductionsInCurrentWord.clear();
 	}
-	return currentWord;
+	std::string result;
+	for (Symbol symbol : currentWord) {
+		if (symbol != kLambdaSymbol) {
+			result += m_symbolTable.GetName(symbol);
+		}
+	}
+	return result;
+}
+SententialForm Grammar::mf_CreateSententialForm() const
+{
+	std::vector<uint32_t> weights(m_symbolTable.Size(), 0);
+	for (Symbol nonterminal : m_nonterminalSymbols) {
+		weights[nonterminal] = static_cast<uint32_t>(mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(nonterminal).size());
+	}
+	return SententialForm(weights, m_isNonterminal, kLambdaSymbol);
+}
+void Grammar::mf_GenerateContextIndependentWord(RandomEngine& engine, SententialForm& form, std::string& word) const
+{
+	// Same choice as the general generator: an applicable production uniformly, then one of the
+	// occurrences of its left part uniformly. A nonterminal is weighted by its number of productions.
+	form.Reset(m_startSymbol);
+	while (form.HasWeightedNonterminals())
+	{
+		const Symbol nonterminal = form.FindNonterminal(engine.NextBelow(form.GetTotalWeight()));
+		const auto& productions = mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(nonterminal);
+		const size_t productionIndex = productions[mf_GetRandom(0, productions.size() - 1, engine)];
+		const size_t occurrence = mf_GetRandom(0, form.GetOccurrencesCount(nonterminal) - 1, engine);
+		form.Replace(form.GetOccurrence(nonterminal, occurrence), m_productions[productionIndex].second);
+	}
+	form.AppendTo(word, m_symbolTable);
 }
 std::vector<std::string> Grammar::GenerateWords(int amount) const
 {
+	return GenerateWords(amount, RandomEngine().GetSeed());
+}
+std::vector<std::string> Grammar::GenerateWords(int amount, uint64_t seed) const
+{
+	// Word i always comes from stream i of the seed, whatever generated the words before it.
+	const RandomEngine seedEngine(seed);
 	std::vector<std::string> result;
 	result.reserve(amount);
 
 	for (int i = 0; i < amount; ++i)
 	{
-		result.push_back(GenerateWord());
+		RandomEngine engine = seedEngine.GetStream(i);
+		result.push_back(GenerateWord(engine));
+	}
+	return result;
+}
+std::vector<uint64_t> Grammar::GeneratesAll(std::span<const std::string> words) const
+{
+	if (m_type != Type::ContextIndependent && m_type != Type::Regular) {
+		throw "The grammar is not context independent.";
+	}
+	if (!VerifyVoidLanguage()) {
+		return std::vector<uint64_t>((words.size() + 63) / 64, 0);
+	}
+	Grammar greibach = *this;
+	greibach.SimplifyGrammar();
+	greibach.MakeItChomsky();
+	greibach.MakeItGreibach();
+	return PushDownAutomaton(greibach).AcceptsAll(words);
+}
+WordSampler Grammar::CreateWordSampler(size_t maxLength) const
+{
+	if (m_type != Type::ContextIndependent && m_type != Type::Regular) {
+		throw "The grammar is not context independent.";
+	}
+	if (!VerifyVoidLanguage()) {
+		throw "The language of the grammar is void.";
+	}
+	Grammar chomsky = *this;
+	chomsky.SimplifyGrammar();
+	chomsky.MakeItChomsky();
+	return WordSampler(chomsky, maxLength);
+}
+LanguageEnumerator Grammar::EnumerateLanguage(size_t maxLength, size_t memoryLimit) const
+{
+	if (m_type != Type::ContextIndependent && m_type != Type::Regular) {
+		throw "The grammar is not context independent.";
 	}
+	if (!VerifyVoidLanguage()) {
+		throw "The language of the grammar is void.";
+	}
+	Grammar chomsky = *this;
+	chomsky.SimplifyGrammar();
+	chomsky.MakeItChomsky();
+	return LanguageEnumerator(chomsky, maxLength, memoryLimit);
+}
+Grammar::GeneratedWords Grammar::GenerateWordsParallel(size_t amount, uint64_t seed) const
+{
+	GeneratedWords result;
+	mf_GenerateWordsParallel(0, amount, seed, result);
 	return result;
 }
+void Grammar::GenerateWordsToFile(size_t amount, uint64_t seed, std::ostream& out) const
+{
+	// A batch is generated in parallel and written before the next one starts, so memory stays bounded.
+	GeneratedWords batch;
+	for (size_t begin = 0; begin < amount; begin += kWordsPerFileBatch) {
+		mf_GenerateWordsParallel(begin, std::min(amount, begin + kWordsPerFileBatch), seed, batch);
+		for (size_t i = 0; i < batch.GetWordsCount(); ++i) {
+			const std::string_view word = batch.GetWord(i);
+			out.write(word.data(), word.size());
+			out.put('\n');
+		}
+	}
+}
+void Grammar::mf_GenerateWordsParallel(size_t begin, size_t end, uint64_t seed, GeneratedWords& words) const
+{
+	if (m_type == Type::Invalid)
+	{
+		throw "The grammar hasn't passed all the tests.";
+	}
+
+	// Each worker appends its words to its own arena and reuses its sentential form; the chunks are then
+	// copied out in index order. Word i comes from stream i of the seed, as in GenerateWords.
+	struct Arena
+	{
+		std::string characters;
+		std::vector<SententialForm> form; // empty when the grammar is not context independent
+	};
+	static constexpr size_t kWordsPerChunk = 256;
+
+	const bool contextIndependent = m_type == Type::ContextIndependent || m_type == Type::Regular;
+	const RandomEngine seedEngine(seed);
+	const size_t amount = end - begin;
+	const size_t chunksCount = (amount + kWordsPerChunk - 1) / kWordsPerChunk;
+	WorkStealingPool& pool = WorkStealingPool::GetShared();
+	std::vector<Arena> arenas(pool.GetThreadsCount());
+	std::vector<size_t> chunkWorkers(chunksCount);
+	std::vector<size_t> chunkArenaBegins(chunksCount);
+	std::vector<size_t> wordArenaEnds(amount);
+
+	pool.Run(chunksCount, [&](size_t workerIndex, size_t chunkIndex) {
+		Arena& arena = arenas[workerIndex];
+		if (contextIndependent && arena.form.empty()) {
+			arena.form.push_back(mf_CreateSententialForm());
+		}
+		chunkWorkers[chunkIndex] = workerIndex;
+		chunkArenaBegins[chunkIndex] = arena.characters.size();
+		const size_t chunkEnd = std::min(amount, (chunkIndex + 1) * kWordsPerChunk);
+		for (size_t i = chunkIndex * kWordsPerChunk; i < chunkEnd; ++i) {
+			RandomEngine engine = seedEngine.GetStream(begin + i);
+			if (contextIndependent) {
+				mf_GenerateContextIndependentWord(engine, arena.form.front(), arena.characters);
+			}
+			else {
+				arena.characters += GenerateWord(engine);
+			}
+			wordArenaEnds[i] = arena.characters.size();
+		}
+	});
+
+	words.m_characters.clear();
+	words.m_offsets.assign(1, 0);
+	words.m_offsets.reserve(amount + 1);
+	for (size_t chunkIndex = 0; chunkIndex < chunksCount; ++chunkIndex) {
+		const std::string& characters = arenas[chunkWorkers[chunkIndex]].characters;
+		const size_t chunkEnd = std::min(amount, (chunkIndex + 1) * kWordsPerChunk);
+		const size_t arenaBegin = chunkArenaBegins[chunkIndex];
+		const size_t outputBegin = words.m_characters.size();
+		words.m_characters.append(characters, arenaBegin, wordArenaEnds[chunkEnd - 1] - arenaBegin);
+		for (size_t i = chunkIndex * kWordsPerChunk; i < chunkEnd; ++i) {
+			words.m_offsets.push_back(outputBegin + wordArenaEnds[i] - arenaBegin);
+		}
+	}
+}
+size_t Grammar::GeneratedWords::GetWordsCount() const
+{
+	return m_offsets.empty() ? 0 : m_offsets.size() - 1;
+}
+std::string_view Grammar::GeneratedWords::GetWord(size_t index) const
+{
+	return std::string_view(m_characters).substr(m_offsets[index], m_offsets[index + 1] - m_offsets[index]);
+}
+const std::string& Grammar::GeneratedWords::GetCharacters() const
+{
+	return m_characters;
+}
+const std::vector<size_t>& Grammar::GeneratedWords::GetOffsets() const
+{
+	return m_offsets;
+}
+
 void Grammar::PrintWord() const
 {
 	std::cout << GenerateWord();
 }
+void Grammar::PrintVerificationErrors() const
+{
+	for (const VerificationError& error : m_verificationErrors)
+	{
+		if (error.production != kNoProduction)
+		{
+			std::cout << "Production " << error.production << " (" << m_symbolTable.ToString(m_productions[error.production].first)
+				<< " ---> " << m_symbolTable.ToString(m_productions[error.production].second) << "): ";
+		}
+		std::cout << error.message << '\n';
+	}
+}
 void Grammar::PrintWords(int amount) const
 {
 	std::vector<std::string> words;
@@ -260,68 +766,80 @@ void Grammar::PrintWords(int amount) const
 	}
 }
 
-bool Grammar::mf_VerifyIntersection() const
+void Grammar::mf_VerifyIntersection()
 {
-	std::unordered_set<char> nonterminals;
-	nonterminals = mf_ConvertVectorOfCharsToUset(m_nonterminalSymbols);
-
-	for (char symbol : m_terminalSymbols)
+	for (Symbol symbol : m_terminalSymbols)
 	{
-		if (nonterminals.count(symbol))
+		if (mf_IsNonterminal(symbol))
 		{
-			return false;
+			m_verificationErrors.push_back({ kNoProduction, "A symbol is both terminal and nonterminal." });
+			return;
 		}
 	}
-	return true;
 }
-bool Grammar::mf_VerifyStartSymbol() const
+void Grammar::mf_VerifyStartSymbol()
 {
-	for (char symbol : m_nonterminalSymbols)
+	if (m_startSymbol == SymbolTable::kNoSymbol || !mf_IsNonterminal(m_startSymbol))
 	{
-		if (symbol == m_startSymbol)
-		{
-			return true;
-		}
+		m_verificationErrors.push_back({ kNoProduction, "The start symbol is not a nonterminal." });
 	}
-	return false;
 }
-bool Grammar::mf_VerifyAtLeastOneNonterminalInProductionLeft() const
+Grammar::Type Grammar::mf_VerifyProduction(size_t productionIndex, bool symbolsAreKnown)
 {
-	std::unordered_set<char> nonterminals;
-	nonterminals = mf_ConvertVectorOfCharsToUset(m_nonterminalSymbols);
+	const auto& [left, right] = m_productions[productionIndex];
+	bool valid = true;
+	auto isKnown = [this](Symbol symbol) {
+		return mf_IsNonterminal(symbol) || mf_IsTerminal(symbol) || symbol == kLambdaSymbol;
+	};
+	if (!mf_StringContainsAtLeastOneElementFromTheSet(left, m_isNonterminal))
+	{
+		m_verificationErrors.push_back({ productionIndex, "The left part has no nonterminal." });
+		valid = false;
+	}
+	if (!symbolsAreKnown && (!std::all_of(left.begin(), left.end(), isKnown) || !std::all_of(right.begin(), right.end(), isKnown)))
+	{
+		m_verificationErrors.push_back({ productionIndex, "The production uses a symbol that is neither terminal nor nonterminal." });
+		valid = false;
+	}
+	if (!valid)
+	{
+		return Type::Invalid;
+	}
 
-	for (const Production& production : m_productions)
+	const bool rightIsLambda = right.size() == 1 && right[0] == kLambdaSymbol;
+	if (left.size() > 1)
 	{
-		if (!mf_StringContainsAtLeastOneElementFromTheSet(production.first, nonterminals))
-		{
-			return false;
-		}
+		// alpha ---> beta with |alpha| <= |beta| is context dependent, a contracting one is unrestricted.
+		const size_t rightLength = rightIsLambda ? 0 : right.size();
+		return rightLength >= left.size() ? Type::ContextDependent : Type::ZeroType;
 	}
-	return true;
+	if (rightIsLambda)
+	{
+		return Type::Regular;
+	}
+	if (right.size() == 1 && mf_IsTerminal(right[0]))
+	{
+		return Type::Regular;
+	}
+	if (right.size() == 2 && mf_IsTerminal(right[0]) && mf_IsNonterminal(right[1]))
+	{
+		return Type::Regular;
+	}
+	return Type::ContextIndependent;
 }
-bool Grammar::mf_VerifyProductions() const
-{
-	std::unordered_set<char> nonterminals;
-	std::unordered_set<char> terminals;
-
-	nonterminals = mf_ConvertVectorOfCharsToUset(m_nonterminalSymbols);
-	terminals = mf_ConvertVectorOfCharsToUset(m_terminalSymbols);
 
-	for (const Production& production : m_productions)
-	{
-		for (char character : production.first)
-		{
-			if (!nonterminals.count(character) && !terminals.count(character) && character != kLambda)
-			{
-				return false;
-			}
+bool Grammar::mf_AllSymbolsAreKnown() const
+{
+	std::vector<uint8_t> isUsed(m_symbolTable.Size(), 0);
+	for (Symbol symbol : m_productions.GetSymbols()) {
+		if (symbol >= isUsed.size()) {
+			return false;
 		}
-		for (char character : production.second)
-		{
-			if (!nonterminals.count(character) && !terminals.count(character) && character != kLambda)
-			{
-				return false;
-			}
+		isUsed[symbol] = 1;
+	}
+	for (Symbol symbol = 0; symbol < isUsed.size(); ++symbol) {
+		if (isUsed[symbol] && symbol != kLambdaSymbol && !mf_IsNonterminal(symbol) && !mf_IsTerminal(symbol)) {
+			return false;
 		}
 	}
 	return true;
@@ -332,86 +850,86 @@ bool Grammar::VerifyVoidLanguage() const
 	if (m_type == Type::ContextDependent || m_type == Type::ZeroType || m_type == Type::Invalid) {
 		return false;
 	}
-	std::vector<DerivationTree> backtracking;
-	backtracking.reserve(5000);
-	size_t currentGenerationIndex = 0;
-
-	std::string startSymbol;
-	startSymbol.push_back(m_startSymbol);
-	backtracking.push_back(DerivationTree(startSymbol));
-	size_t nextGenerationIndex = backtracking.size();
 
-	auto nonterminalsSet = mf_ConvertVectorOfCharsToUset(m_nonterminalSymbols);
+	return mf_GetProductiveNonterminals()[m_startSymbol];
+}
+std::vector<bool> Grammar::mf_GetProductiveNonterminals() const
+{
+	// Every production counts the nonterminal occurrences of its right part that are not known to be
+	// productive yet; when the count drops to zero its left part becomes productive. Each occurrence is
+	// decremented once, so the whole pass is linear in the size of the grammar.
+	std::vector<bool> isProductive(m_symbolTable.Size(), false);
+	std::vector<size_t> unresolvedSymbols(m_productions.Size(), 0);
+	std::vector<Symbol> productiveWorklist;
 
-	while (true) {
-		for (size_t i = currentGenerationIndex; i < nextGenerationIndex; ++i) {
-			std::vector<std::pair<DerivationTree::Node*, std::vector<size_t>>> aplicableProductionOnNonterminalNodes;
-			for (DerivationTree::Node* node : backtracking[i].GetLeaves()) {
-				if (nonterminalsSet.count(node->GetSymbols()[0])) {
-					std::vector<size_t> aplicableProductionOnCurrentNode;
-					for (size_t i = 0; i < m_productions.size(); ++i) {
-						if (m_productions[i].first[0] == node->GetSymbols()[0]) {
-							aplicableProductionOnCurrentNode.push_back(i);
-						}
-					}
-					aplicableProductionOnNonterminalNodes.emplace_back(node, aplicableProductionOnCurrentNode);
-				}
-			}
-			for (const auto& pair : aplicableProductionOnNonterminalNodes) {
-				auto& [node, productionIndexes] = pair;
-				for (const auto& index : productionIndexes) {
-					mf_AddChildrensFromStringToNode(node, m_productions[index].second);
-					if (backtracking[i].GetLongestPath() <= m_nonterminalSymbols.size()) {
-						backtracking.push_back(backtracking[i]);
-					}
-					node->ClearChildrens();
-				}
+	for (size_t i = 0; i < m_productions.Size(); ++i) {
+		for (Symbol symbol : m_productions[i].second) {
+			if (mf_IsNonterminal(symbol)) {
+				++unresolvedSymbols[i];
 			}
 		}
-		currentGenerationIndex = nextGenerationIndex;
-		nextGenerationIndex = backtracking.size();
-		if (currentGenerationIndex == nextGenerationIndex) {
-			break;
+		const Symbol left = m_productions[i].first[0];
+		if (!unresolvedSymbols[i] && !isProductive[left]) {
+			isProductive[left] = true;
+			productiveWorklist.push_back(left);
 		}
 	}
 
-	for (const auto& tree : backtracking) {
-		if (mf_ContainsOnlyTerminals(tree.GetResult())) {
-			return true;
+	while (!productiveWorklist.empty()) {
+		const Symbol symbol = productiveWorklist.back();
+		productiveWorklist.pop_back();
+		for (size_t productionIndex : mf_GetProductionsUsing(symbol)) {
+			const Symbol left = m_productions[productionIndex].first[0];
+			if (!--unresolvedSymbols[productionIndex] && !isProductive[left]) {
+				isProductive[left] = true;
+				productiveWorklist.push_back(left);
+			}
 		}
 	}
-	return false;
+	return isProductive;
 }
 
-bool Grammar::mf_StringContainsAtLeastOneElementFromTheSet(const std::string& string, const std::unordered_set<char>& set) const
+bool Grammar::mf_StringContainsAtLeastOneElementFromTheSet(SymbolStringView string, const std::vector<bool>& set) const
 {
-	for (char character : string)
+	for (Symbol symbol : string)
 	{
-		if (set.count(character))
+		if (symbol < set.size() && set[symbol])
 		{
 			return true;
 		}
 	}
 	return false;
 }
-std::unordered_set<char> Grammar::mf_ConvertVectorOfCharsToUset(const std::vector<char>& vector) const
+void Grammar::mf_UpdateSymbolSets()
 {
-	std::unordered_set<char> result;
-	for (char character : vector)
-	{
-		result.insert(character);
-	}
-	return result;
+	m_isNonterminal = mf_ConvertSymbolsToBitset(m_nonterminalSymbols);
+	m_isTerminal = mf_ConvertSymbolsToBitset(m_terminalSymbols);
+}
+void Grammar::mf_AddNonterminal(Symbol symbol)
+{
+	m_nonterminalSymbols.push_back(symbol);
+	m_isNonterminal.resize(m_symbolTable.Size(), false);
+	m_isTerminal.resize(m_symbolTable.Size(), false);
+	m_isNonterminal[symbol] = true;
+}
+bool Grammar::mf_IsNonterminal(Symbol symbol) const
+{
+	return symbol < m_isNonterminal.size() && m_isNonterminal[symbol];
 }
-std::vector<char> Grammar::mf_ConvertUsetOfStringsToVectorOfChars(const std::unordered_set<std::string>& uSet) const
+bool Grammar::mf_IsTerminal(Symbol symbol) const
 {
-	std::vector<char> result;
-	for (const auto& character : uSet) {
-		result.push_back(character[0]);
+	return symbol < m_isTerminal.size() && m_isTerminal[symbol];
+}
+std::vector<bool> Grammar::mf_ConvertSymbolsToBitset(const std::vector<Symbol>& symbols) const
+{
+	std::vector<bool> result(m_symbolTable.Size(), false);
+	for (Symbol symbol : symbols)
+	{
+		result[symbol] = true;
 	}
 	return result;
 }
-std::vector<int> Grammar::mf_GetSubstrPositionsInString(const std::string& substr, const std::string& string) const
+std::vector<int> Grammar::mf_GetSubstrPositionsInString(SymbolStringView substr, SymbolStringView string) const
 {
 	std::vector<int> result;
 	if (substr.size() > string.size())
@@ -431,9 +949,9 @@ std::vector<int> Grammar::mf_GetSubstrPositionsInString(const std::string& subst
 	}
 	return result;
 }
-void Grammar::mf_ApplyProductionOnString(int productionIndex, int positionInString, std::string& string) const
+void Grammar::mf_ApplyProductionOnString(int productionIndex, int positionInString, SymbolString& string) const
 {
-	const Production& appliedProduction = m_productions[productionIndex];
+	const ProductionList::ProductionView appliedProduction = m_productions[productionIndex];
 	size_t differenceInSizes = appliedProduction.second.size() - appliedProduction.first.size();
 
 	if (!differenceInSizes)
@@ -445,7 +963,7 @@ void Grammar::mf_ApplyProductionOnString(int productionIndex, int positionInStri
 		return;
 	}
 
-	std::string newString;
+	SymbolString newString;
 	newString.reserve(string.size() + differenceInSizes);
 
 	for (int i = 0; i < positionInString; ++i)
@@ -463,53 +981,169 @@ void Grammar::mf_ApplyProductionOnString(int productionIndex, int positionInStri
 	string = newString;
 }
 
-void Grammar::mf_AddChildrensFromStringToNode(DerivationTree::Node* node, const std::string& string) const
+bool Grammar::mf_ContainsOnlyTerminals(SymbolStringView string) const
 {
-	for (auto character : string) {
-		std::string aux;
-		aux.push_back(character);
-		node->AddChildren(new DerivationTree::Node(aux));
+	for (Symbol symbol : string) {
+		if (!mf_IsTerminal(symbol)) {
+			return false;
+		}
 	}
+	return true;
 }
 
-bool Grammar::mf_ContainsOnlyTerminals(const std::string& string) const
+
+std::vector<bool> Grammar::mf_GetDifferenceBetweenCurrentNonterminalsAndNewNonterminals(const std::vector<bool>& newNonterminals) const
 {
-	auto vt = mf_ConvertVectorOfCharsToUset(m_terminalSymbols);
-	for (char character : string) {
-		if (!vt.count(character)) {
-			return false;
+	std::vector<bool> result(m_symbolTable.Size(), false);
+	for (Symbol symbol : m_nonterminalSymbols) {
+		if (!newNonterminals[symbol]) {
+			result[symbol] = true;
 		}
 	}
-	return true;
+	return result;
 }
 
-std::string Grammar::mf_ConvertCharToSizeOneString(char character) const
+const std::vector<uint32_t>& Grammar::mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(Symbol nonterminal) const
 {
-	std::string result;
-	result.push_back(character);
-	return result;
+	static const std::vector<uint32_t> kNoProductions;
+	mf_EnsureProductionIndexes();
+	return nonterminal < m_productionsByLeft.size() ? m_productionsByLeft[nonterminal] : kNoProductions;
+}
+const std::vector<uint32_t>& Grammar::mf_GetProductionsUsing(Symbol symbol) const
+{
+	static const std::vector<uint32_t> kNoProductions;
+	mf_EnsureProductionIndexes();
+	return symbol < m_productionsByRight.size() ? m_productionsByRight[symbol] : kNoProductions;
 }
 
-std::unordered_set<std::string> Grammar::mf_GetDifferenceBetweenCurrentNonterminalsAndNewNonterminals(const std::unordered_set<std::string>& newNonterminals) const
+void Grammar::mf_InvalidateProductionIndexes()
+{
+	// Reading a grammar does not pay for indexes that may never be asked for.
+	m_productionsByLeft.clear();
+	m_productionsByRight.clear();
+	m_savedProductionIndexes = SavedProductionIndexes();
+	m_productionIndexesAreBuilt.store(false, std::memory_order_release);
+}
+void Grammar::mf_EnsureProductionIndexes() const
 {
-	std::unordered_set<std::string> result;
-	for (char character : m_nonterminalSymbols) {
-		if (!newNonterminals.count(mf_ConvertCharToSizeOneString(character))) {
-			result.insert(mf_ConvertCharToSizeOneString(character));
+	if (m_productionIndexesAreBuilt.load(std::memory_order_acquire)) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(m_productionIndexesMutex);
+	if (!m_productionIndexesAreBuilt.load(std::memory_order_relaxed)) {
+		mf_BuildProductionIndexes();
+		m_productionIndexesAreBuilt.store(true, std::memory_order_release);
+	}
+}
+void Grammar::mf_BuildProductionIndexes() const
+{
+	const SavedProductionIndexes& saved = m_savedProductionIndexes;
+	if (!saved.leftOffsets.empty()) {
+		m_productionsByLeft.resize(saved.leftOffsets.size() - 1);
+		m_productionsByRight.resize(saved.rightOffsets.size() - 1);
+		for (size_t symbol = 0; symbol + 1 < saved.leftOffsets.size(); ++symbol) {
+			m_productionsByLeft[symbol].assign(saved.leftEntries.begin() + saved.leftOffsets[symbol], saved.leftEntries.begin() + saved.leftOffsets[symbol + 1]);
+			m_productionsByRight[symbol].assign(saved.rightEntries.begin() + saved.rightOffsets[symbol], saved.rightEntries.begin() + saved.rightOffsets[symbol + 1]);
+		}
+		return;
+	}
+	// Counted first, so every list is allocated once at its final size.
+	std::vector<size_t> leftCounts(m_symbolTable.Size(), 0);
+	std::vector<size_t> rightCounts(m_symbolTable.Size(), 0);
+	for (const auto& [left, right] : m_productions) {
+		for (Symbol symbol : left) {
+			++leftCounts[symbol];
+		}
+		for (Symbol symbol : right) {
+			++rightCounts[symbol];
+		}
+	}
+	m_productionsByLeft.assign(m_symbolTable.Size(), {});
+	m_productionsByRight.assign(m_symbolTable.Size(), {});
+	for (Symbol symbol = 0; symbol < m_symbolTable.Size(); ++symbol) {
+		m_productionsByLeft[symbol].reserve(leftCounts[symbol]);
+		m_productionsByRight[symbol].reserve(rightCounts[symbol]);
+	}
+	for (size_t i = 0; i < m_productions.Size(); ++i) {
+		const auto [left, right] = m_productions[i];
+		for (Symbol symbol : left) {
+			m_productionsByLeft[symbol].push_back(static_cast<uint32_t>(i));
+		}
+		for (Symbol symbol : right) {
+			m_productionsByRight[symbol].push_back(static_cast<uint32_t>(i));
 		}
 	}
-	return result;
 }
-
-std::vector<size_t> Grammar::mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(const std::string& nonterminal) const
+void Grammar::mf_IndexProduction(size_t productionIndex)
 {
-	std::vector<size_t> result;
-	for (size_t i = 0; i < m_productions.size(); ++i) {
-		if (m_productions[i].first[0] == nonterminal[0]) {
-			result.push_back(i);
+	if (m_productionsByLeft.size() < m_symbolTable.Size()) {
+		m_productionsByLeft.resize(m_symbolTable.Size());
+		m_productionsByRight.resize(m_symbolTable.Size());
+	}
+	for (Symbol symbol : m_productions[productionIndex].first) {
+		m_productionsByLeft[symbol].push_back(static_cast<uint32_t>(productionIndex));
+	}
+	for (Symbol symbol : m_productions[productionIndex].second) {
+		m_productionsByRight[symbol].push_back(static_cast<uint32_t>(productionIndex));
+	}
+}
+void Grammar::mf_UnindexProduction(size_t productionIndex, bool leftPart, bool rightPart)
+{
+	// Removes one entry per occurrence; the last entry of the list takes its place.
+	auto unindex = [productionIndex](std::vector<uint32_t>& productions) {
+		auto it = std::find(productions.begin(), productions.end(), productionIndex);
+		*it = productions.back();
+		productions.pop_back();
+	};
+	if (leftPart) {
+		for (Symbol symbol : m_productions[productionIndex].first) {
+			unindex(m_productionsByLeft[symbol]);
+		}
+	}
+	if (rightPart) {
+		for (Symbol symbol : m_productions[productionIndex].second) {
+			unindex(m_productionsByRight[symbol]);
 		}
 	}
-	return result;
+}
+size_t Grammar::mf_AddProduction(SymbolStringView left, SymbolStringView right)
+{
+	// The edits below keep built indexes up to date, so they are built before the first one.
+	mf_EnsureProductionIndexes();
+	const size_t productionIndex = m_productions.Add(left, right);
+	mf_IndexProduction(productionIndex);
+	return productionIndex;
+}
+void Grammar::mf_RemoveProduction(size_t productionIndex)
+{
+	// The last production is moved into the freed index, so only its entries need renumbering.
+	mf_EnsureProductionIndexes();
+	mf_UnindexProduction(productionIndex, true, true);
+	const size_t lastIndex = m_productions.Size() - 1;
+	if (productionIndex != lastIndex) {
+		auto renumber = [productionIndex, lastIndex](std::vector<uint32_t>& productions) {
+			std::replace(productions.begin(), productions.end(), static_cast<uint32_t>(lastIndex), static_cast<uint32_t>(productionIndex));
+		};
+		for (Symbol symbol : m_productions[lastIndex].first) {
+			renumber(m_productionsByLeft[symbol]);
+		}
+		for (Symbol symbol : m_productions[lastIndex].second) {
+			renumber(m_productionsByRight[symbol]);
+		}
+	}
+	m_productions.Remove(productionIndex);
+}
+void Grammar::mf_SetProductionRightPart(size_t productionIndex, SymbolStringView rightPart)
+{
+	mf_EnsureProductionIndexes();
+	mf_UnindexProduction(productionIndex, false, true);
+	m_productions.SetRightPart(productionIndex, rightPart);
+	if (m_productionsByRight.size() < m_symbolTable.Size()) {
+		m_productionsByRight.resize(m_symbolTable.Size());
+	}
+	for (Symbol symbol : m_productions[productionIndex].second) {
+		m_productionsByRight[symbol].push_back(static_cast<uint32_t>(productionIndex));
+	}
 }
 
 void Grammar::SimplifyGrammar()
@@ -520,6 +1154,7 @@ void Grammar::SimplifyGrammar()
 	if (!VerifyVoidLanguage()) {
 		return;
 	}
+	mf_RemoveLambdaProductions();
 	mf_RemoveRenames();
 	mf_RemoveUnusableNonterminals();
 	mf_RemoveUnaccesibleNonterminals();
@@ -532,421 +1167,419 @@ void Grammar::MakeItChomsky()
 }
 void Grammar::MakeItGreibach()
 {
-	mf_GreibachPartOne();
-	mf_GreibachPartTwo();
-	mf_GreibachPartThree();
+	const std::vector<Symbol> order = m_nonterminalSymbols;
+	mf_GreibachPartOne(order);
+	mf_GreibachPartTwo(order);
+	mf_GreibachPartThree(order);
 }
 
-void Grammar::mf_RemoveUnusableNonterminals()
+void Grammar::mf_RemoveLambdaProductions()
 {
-	std::unordered_set<std::string> newNonterminals;
-	while (true)
-	{
-		std::unordered_set<std::string> currentNewNonterminals = newNonterminals;
-		for (const auto& production : m_productions) {
-			if (mf_ContainsOnlyTerminalsOrTerminalsAndNonterminalsFromUset(production.second, newNonterminals)) {
-				currentNewNonterminals.insert(production.first);
+	const std::vector<bool> isNullable = mf_GetNullableNonterminals();
+	if (std::none_of(m_nonterminalSymbols.begin(), m_nonterminalSymbols.end(), [&isNullable](Symbol symbol) { return isNullable[symbol]; })) {
+		return;
+	}
+
+	// Every production is replaced by the nonempty strings obtained by dropping some of its nullable
+	// symbols. They are built in one buffer and only the new ones are copied out, one set per left part.
+	ProductionList newProductions;
+	std::unordered_set<SymbolString> expansions;
+	SymbolString expansion;
+	for (Symbol nonterminal : m_nonterminalSymbols) {
+		expansions.clear();
+		for (size_t productionIndex : mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(nonterminal)) {
+			const SymbolStringView right = m_productions[productionIndex].second;
+			if (right.size() == 1 && right[0] == kLambdaSymbol) {
+				continue;
 			}
+			mf_ExpandNullableSymbols(right, 0, isNullable, expansion, expansions);
 		}
-		if (currentNewNonterminals == newNonterminals) {
-			break;
+		expansions.erase(SymbolString(1, nonterminal)); // A ---> A, left when the rest of A ---> AB is nullable
+		for (const SymbolString& right : expansions) {
+			newProductions.Add(SymbolString(1, nonterminal), right);
 		}
-		newNonterminals = currentNewNonterminals;
 	}
-	std::unordered_set<std::string> toBeRemovedNonterminals = mf_GetDifferenceBetweenCurrentNonterminalsAndNewNonterminals(newNonterminals);
-	std::vector<Production> newProductions;
-	for (const auto& production : m_productions) {
-		bool productionIsGood = true;
-		for (char character : production.first) {
-			if (toBeRemovedNonterminals.count(mf_ConvertCharToSizeOneString(character))) {
-				productionIsGood = false;
-				break;
-			}
+
+	// The empty word stays in the language through S ---> lambda alone; when S is also used in a right
+	// part, a new start symbol takes that production so no right part can derive lambda.
+	if (isNullable[m_startSymbol]) {
+		bool startSymbolIsUsed = false;
+		for (const auto& [left, right] : newProductions) {
+			startSymbolIsUsed = startSymbolIsUsed || right.find(m_startSymbol) != SymbolStringView::npos;
 		}
-		if (!productionIsGood) {
-			continue;
+		if (startSymbolIsUsed) {
+			const Symbol newStartSymbol = mf_GetTheNextSymbolToBeAddedInProductions();
+			mf_AddNonterminal(newStartSymbol);
+			newProductions.Add(SymbolString(1, newStartSymbol), SymbolString(1, m_startSymbol));
+			m_startSymbol = newStartSymbol;
+		}
+		newProductions.Add(SymbolString(1, m_startSymbol), SymbolString(1, kLambdaSymbol));
+	}
+	m_productions = std::move(newProductions);
+	mf_InvalidateProductionIndexes();
+}
+std::vector<bool> Grammar::mf_GetNullableNonterminals() const
+{
+	// The same counting as for the productive nonterminals, where only nullable nonterminals resolve an
+	// occurrence: a terminal keeps its production from ever reaching zero, a lambda right part starts there.
+	std::vector<bool> isNullable(m_symbolTable.Size(), false);
+	std::vector<size_t> unresolvedSymbols(m_productions.Size(), 0);
+	std::vector<Symbol> nullableWorklist;
+
+	for (size_t i = 0; i < m_productions.Size(); ++i) {
+		const SymbolStringView right = m_productions[i].second;
+		unresolvedSymbols[i] = right.size() == 1 && right[0] == kLambdaSymbol ? 0 : right.size();
+		const Symbol left = m_productions[i].first[0];
+		if (!unresolvedSymbols[i] && !isNullable[left]) {
+			isNullable[left] = true;
+			nullableWorklist.push_back(left);
 		}
-		for (char character : production.second) {
-			if (toBeRemovedNonterminals.count(mf_ConvertCharToSizeOneString(character))) {
-				productionIsGood = false;
-				break;
+	}
+
+	while (!nullableWorklist.empty()) {
+		const Symbol symbol = nullableWorklist.back();
+		nullableWorklist.pop_back();
+		for (size_t productionIndex : mf_GetProductionsUsing(symbol)) {
+			const Symbol left = m_productions[productionIndex].first[0];
+			if (!--unresolvedSymbols[productionIndex] && !isNullable[left]) {
+				isNullable[left] = true;
+				nullableWorklist.push_back(left);
 			}
 		}
-		if (productionIsGood) {
-			newProductions.push_back(production);
+	}
+	return isNullable;
+}
+void Grammar::mf_ExpandNullableSymbols(SymbolStringView right, size_t position, const std::vector<bool>& isNullable, SymbolString& expansion, std::unordered_set<SymbolString>& expansions) const
+{
+	if (position == right.size()) {
+		if (!expansion.empty() && !expansions.count(expansion)) {
+			expansions.insert(expansion);
 		}
+		return;
 	}
-	m_productions = newProductions;
-	m_nonterminalSymbols.clear();
-	m_nonterminalSymbols.reserve(newNonterminals.size());
-	for (const auto& string : newNonterminals) {
-		m_nonterminalSymbols.push_back(string[0]);
+	expansion.push_back(right[position]);
+	mf_ExpandNullableSymbols(right, position + 1, isNullable, expansion, expansions);
+	expansion.pop_back();
+	if (isNullable[right[position]]) {
+		mf_ExpandNullableSymbols(right, position + 1, isNullable, expansion, expansions);
 	}
 }
+void Grammar::mf_RemoveUnusableNonterminals()
+{
+	std::vector<bool> newNonterminals = mf_GetProductiveNonterminals();
+	mf_RemoveNonterminalsNotIn(newNonterminals);
+}
 void Grammar::mf_RemoveUnaccesibleNonterminals()
 {
-	std::unordered_set<std::string> newNonterminals;
-	newNonterminals.insert(mf_ConvertCharToSizeOneString(m_startSymbol));
-	while (true)
+	std::vector<bool> newNonterminals(m_symbolTable.Size(), false);
+	std::vector<Symbol> worklist{ m_startSymbol };
+	newNonterminals[m_startSymbol] = true;
+	while (!worklist.empty())
 	{
-		std::unordered_set<std::string> currentNewNonterminals = newNonterminals;
-		for (const auto& production : m_productions)
+		const Symbol nonterminal = worklist.back();
+		worklist.pop_back();
+		for (size_t productionIndex : mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(nonterminal))
 		{
-			if (currentNewNonterminals.count(production.first))
-			{
-				for (const auto& string : mf_GetAllNonterminalsFromString(production.second)) {
-					currentNewNonterminals.insert(string);
+			for (Symbol symbol : mf_GetAllNonterminalsFromString(m_productions[productionIndex].second)) {
+				if (!newNonterminals[symbol]) {
+					newNonterminals[symbol] = true;
+					worklist.push_back(symbol);
 				}
 			}
 		}
-		if (currentNewNonterminals == newNonterminals)
-		{
-			break;
-		}
-		newNonterminals = currentNewNonterminals;
 	}
-	std::unordered_set<std::string> toBeRemovedNonterminals = mf_GetDifferenceBetweenCurrentNonterminalsAndNewNonterminals(newNonterminals);
-	std::vector<Production> newProductions;
-	for (const auto& production : m_productions) {
-		bool productionIsGood = true;
-		for (char character : production.first) {
-			if (toBeRemovedNonterminals.count(mf_ConvertCharToSizeOneString(character))) {
-				productionIsGood = false;
-				break;
-			}
-		}
-		if (!productionIsGood) {
+	mf_RemoveNonterminalsNotIn(newNonterminals);
+}
+void Grammar::mf_RemoveNonterminalsNotIn(const std::vector<bool>& newNonterminals)
+{
+	std::vector<bool> toBeRemovedNonterminals = mf_GetDifferenceBetweenCurrentNonterminalsAndNewNonterminals(newNonterminals);
+	ProductionList newProductions;
+	for (const auto& [left, right] : m_productions) {
+		if (mf_StringContainsAtLeastOneElementFromTheSet(left, toBeRemovedNonterminals)) {
 			continue;
 		}
-		for (char character : production.second) {
-			if (toBeRemovedNonterminals.count(mf_ConvertCharToSizeOneString(character))) {
-				productionIsGood = false;
-				break;
-			}
+		if (mf_StringContainsAtLeastOneElementFromTheSet(right, toBeRemovedNonterminals)) {
+			continue;
 		}
-		if (productionIsGood) {
-			newProductions.push_back(production);
+		newProductions.Add(left, right);
+	}
+	m_productions = std::move(newProductions);
+	mf_InvalidateProductionIndexes();
+	std::vector<Symbol> remainingNonterminals;
+	remainingNonterminals.reserve(m_nonterminalSymbols.size());
+	for (Symbol symbol : m_nonterminalSymbols) {
+		if (newNonterminals[symbol]) {
+			remainingNonterminals.push_back(symbol);
 		}
 	}
-	m_productions = newProductions;
-	m_nonterminalSymbols.clear();
-	m_nonterminalSymbols.reserve(newNonterminals.size());
-	for (const auto& string : newNonterminals) {
-		m_nonterminalSymbols.push_back(string[0]);
-	}
+	m_nonterminalSymbols = std::move(remainingNonterminals);
+	mf_UpdateSymbolSets();
 }
 void Grammar::mf_RemoveRenames()
 {
-	auto vn = mf_ConvertVectorOfCharsToUset(m_nonterminalSymbols);
-	std::vector<Production> newProductions;
-	std::unordered_set<size_t> renames;
-	for (size_t i = 0; i < m_productions.size(); ++i) {
-		const auto& rightPart = m_productions[i].second;
-		if (rightPart.size() == 1 && vn.count(rightPart[0])) {
-			renames.insert(i);
-		}
+	auto isRename = [this](SymbolStringView rightPart) {
+		return rightPart.size() == 1 && mf_IsNonterminal(rightPart[0]);
+	};
+	bool hasRenames = false;
+	for (const auto& [left, right] : m_productions) {
+		hasRenames = hasRenames || isRename(right);
+	}
+	if (!hasRenames) {
+		return;
 	}
-	for (size_t i = 0; i < m_productions.size(); ++i) {
-		if (renames.count(i)) {
-			continue;
+
+	// A ---> B ---> ... ---> C ---> alpha gives A ---> alpha, so every nonterminal takes the right parts
+	// that are not renames from all the nonterminals it reaches through renames, itself included.
+	ProductionList newProductions;
+	std::vector<bool> isRenamed(m_symbolTable.Size(), false);
+	std::vector<Symbol> renamedNonterminals;
+	std::unordered_set<SymbolStringView> rightParts; // views into m_productions, which stays as it is until the end
+	for (Symbol nonterminal : m_nonterminalSymbols) {
+		renamedNonterminals.assign(1, nonterminal);
+		isRenamed[nonterminal] = true;
+		rightParts.clear();
+		for (size_t i = 0; i < renamedNonterminals.size(); ++i) {
+			for (size_t productionIndex : mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(renamedNonterminals[i])) {
+				const SymbolStringView rightPart = m_productions[productionIndex].second;
+				if (!isRename(rightPart)) {
+					if (rightParts.insert(rightPart).second) {
+						newProductions.Add(SymbolString(1, nonterminal), rightPart);
+					}
+				}
+				else if (!isRenamed[rightPart[0]]) {
+					isRenamed[rightPart[0]] = true;
+					renamedNonterminals.push_back(rightPart[0]);
+				}
+			}
 		}
-		newProductions.push_back(m_productions[i]);
-	}
-	for (size_t renameIndex : renames) {
-		for (size_t productionIndex : mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(m_productions[renameIndex].second)) {
-			newProductions.emplace_back(m_productions[renameIndex].first, m_productions[productionIndex].second);
+		for (Symbol symbol : renamedNonterminals) {
+			isRenamed[symbol] = false;
 		}
 	}
-	m_productions = newProductions;
+	m_productions = std::move(newProductions);
+	mf_InvalidateProductionIndexes();
 }
 
 void Grammar::mf_ChomskyPartTwo()
 {
-	std::vector<Production> newProductions;
+	ProductionList newProductions;
 	std::unordered_set<size_t> productionsIndexesThatHaveMoreThanOneInRightPart;
+	std::vector<Symbol> nonterminalOfTerminal(m_symbolTable.Size(), SymbolTable::kNoSymbol); // the new X ---> a of every a
+	SymbolString rightPart;
 
-	auto vn = mf_ConvertVectorOfCharsToUset(m_nonterminalSymbols);
-	auto vt = mf_ConvertVectorOfCharsToUset(m_terminalSymbols);
-
-	for (size_t i = 0; i < m_productions.size(); ++i) {
+	for (size_t i = 0; i < m_productions.Size(); ++i) {
 		if (m_productions[i].second.size() > 1) {
 			productionsIndexesThatHaveMoreThanOneInRightPart.insert(i);
 			continue;
 		}
-		newProductions.push_back(m_productions[i]);
+		newProductions.Add(m_productions[i].first, m_productions[i].second);
 	}
 	for (size_t index : productionsIndexesThatHaveMoreThanOneInRightPart) {
-		for (size_t i = 0; i < m_productions[index].second.size(); ++i) {
-			auto& currentCharacter = m_productions[index].second[i];
-			if (vt.count(currentCharacter)) {
-				auto& nts = m_nonterminalSymbols;
-				auto nonterminalThatAlreadyExists = mf_ReturnNonTerminalThatGoesOnlyInTerminal(newProductions, currentCharacter);
-				if (nonterminalThatAlreadyExists.size()) {
-					currentCharacter = nonterminalThatAlreadyExists[0];
+		rightPart.assign(m_productions[index].second);
+		for (size_t i = 0; i < rightPart.size(); ++i) {
+			auto& currentSymbol = rightPart[i];
+			if (mf_IsTerminal(currentSymbol)) {
+				Symbol nonterminalThatAlreadyExists = nonterminalOfTerminal[currentSymbol];
+				if (nonterminalThatAlreadyExists != SymbolTable::kNoSymbol) {
+					currentSymbol = nonterminalThatAlreadyExists;
 					continue;
 				}
-				std::string nextNonterminal = mf_GetTheNextSymbolToBeAddedInProductions(newProductions);
-				nts.push_back(nextNonterminal[0]);
-				newProductions.emplace_back(nextNonterminal, mf_ConvertCharToSizeOneString(currentCharacter));
-				currentCharacter = nextNonterminal[0];
+				Symbol nextNonterminal = mf_GetTheNextSymbolToBeAddedInProductions();
+				mf_AddNonterminal(nextNonterminal);
+				newProductions.Add(SymbolString(1, nextNonterminal), SymbolString(1, currentSymbol));
+				nonterminalOfTerminal[currentSymbol] = nextNonterminal;
+				currentSymbol = nextNonterminal;
 			}
 		}
-		newProductions.push_back(m_productions[index]);
+		newProductions.Add(m_productions[index].first, rightPart);
 	}
-	m_productions = newProductions;
+	m_productions = std::move(newProductions);
+	mf_InvalidateProductionIndexes();
 }
 
 void Grammar::mf_ChomskyPartThree()
 {
-	std::vector<Production>newProductions;
+	ProductionList newProductions;
 	std::vector<size_t>productionsThatHaveMoreThanTwoInRightIndexes;
-	for (size_t i = 0; i < m_productions.size(); ++i) {
+	for (size_t i = 0; i < m_productions.Size(); ++i) {
 		if (m_productions[i].second.size() > 2) {
 			productionsThatHaveMoreThanTwoInRightIndexes.push_back(i);
 			continue;
 		}
-		newProductions.push_back(m_productions[i]);
+		newProductions.Add(m_productions[i].first, m_productions[i].second);
 	}
 	for (size_t index : productionsThatHaveMoreThanTwoInRightIndexes) {
-		std::string currentRightPartOfProduction = m_productions[index].second;
-		std::string lastCreatedNonTerminal = mf_GetTheNextSymbolToBeAddedInProductions(newProductions);
-		m_nonterminalSymbols.push_back(lastCreatedNonTerminal[0]);
-		m_productions[index].second.resize(2);
-		m_productions[index].second[1] = lastCreatedNonTerminal[0];
-		newProductions.push_back(m_productions[index]);
+		const SymbolStringView currentRightPartOfProduction = m_productions[index].second;
+		Symbol lastCreatedNonTerminal = mf_GetTheNextSymbolToBeAddedInProductions();
+		mf_AddNonterminal(lastCreatedNonTerminal);
+		newProductions.Add(m_productions[index].first, SymbolString{ currentRightPartOfProduction[0], lastCreatedNonTerminal });
 		for (size_t i = 1; i < currentRightPartOfProduction.size() - 2; ++i) {
-			std::string newNonTerminal = mf_GetTheNextSymbolToBeAddedInProductions(newProductions);
-			m_nonterminalSymbols.push_back(newNonTerminal[0]);
-			newNonTerminal.push_back(currentRightPartOfProduction[i]);
-			std::swap(newNonTerminal[0], newNonTerminal[1]);
-			newProductions.emplace_back(lastCreatedNonTerminal, newNonTerminal);
-			std::swap(newNonTerminal[0], newNonTerminal[1]);
-			newNonTerminal.resize(1);
+			Symbol newNonTerminal = mf_GetTheNextSymbolToBeAddedInProductions();
+			mf_AddNonterminal(newNonTerminal);
+			newProductions.Add(SymbolString(1, lastCreatedNonTerminal), SymbolString{ currentRightPartOfProduction[i], newNonTerminal });
 			lastCreatedNonTerminal = newNonTerminal;
 		}
-		newProductions.emplace_back(lastCreatedNonTerminal, currentRightPartOfProduction.substr(currentRightPartOfProduction.size() - 2));
+		newProductions.Add(SymbolString(1, lastCreatedNonTerminal), currentRightPartOfProduction.substr(currentRightPartOfProduction.size() - 2));
 	}
-	m_productions = newProductions;
+	m_productions = std::move(newProductions);
+	mf_InvalidateProductionIndexes();
 }
 
-void Grammar::mf_GreibachPartOne()
+void Grammar::mf_GreibachPartOne(const std::vector<Symbol>& order)
 {
-	std::vector<Production> beforeModificationProductions = m_productions;
-	while (true) {
+	const std::vector<size_t> rank = mf_GreibachRanks(order);
+	for (size_t i = 0; i < order.size(); ++i) {
+		mf_GreibachSubstituteLeadingNonterminals(order[i], rank, i);
 		std::vector<size_t> recursiveProductions;
 		std::vector<size_t> nonrecursiveProductions;
-		char* currentScopedSymbol = nullptr;
-		bool applyFirstLema = true;
-		for (int i = 0; i < m_productions.size(); ++i) {
-			auto vt = mf_ConvertVectorOfCharsToUset(m_terminalSymbols);
-			if (m_productions[i].first[0] == m_startSymbol || (m_productions[i].first[0] >= 33 && m_productions[i].first[0] <= 64)) {
-				continue;
-			}
-			if (vt.count(m_productions[i].second[0])) {
-				continue;
+		for (size_t j : mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(order[i])) {
+			if (m_productions[j].second[0] == order[i]) {
+				recursiveProductions.push_back(j);
 			}
-			if (currentScopedSymbol == nullptr) {
-				currentScopedSymbol = new char(m_productions[i].first[0]);
-				--i;
-				continue;
-			}
-			if (m_productions[i].first[0] == *currentScopedSymbol) {
-				if (applyFirstLema) {
-					if (m_productions[i].first[0] == m_productions[i].second[0]) {
-						applyFirstLema = false;
-						--i;
-						continue;
-					}
-					if (!vt.count(m_productions[i].second[0])) {
-						mf_GreibachFirstLema(i, 0);
-						--i;
-					}
-				}
-				if (m_productions[i].first[0] == m_productions[i].second[0]) {
-					recursiveProductions.push_back(i);
-				}
+			else {
+				nonrecursiveProductions.push_back(j);
 			}
 		}
-		if (!applyFirstLema) {
-			for (int i = 0; i < m_productions.size(); ++i) {
-				if (m_productions[i].first[0] == *currentScopedSymbol && m_productions[i].second.size() == 1) {
-					nonrecursiveProductions.push_back(i);
-				}
-			}
+		if (!recursiveProductions.empty()) {
 			mf_GreibachSecondLema(recursiveProductions, nonrecursiveProductions);
 		}
-		delete currentScopedSymbol;
-		if (beforeModificationProductions == m_productions) {
-			break;
-		}
-		beforeModificationProductions = m_productions;
 	}
 }
-void Grammar::mf_GreibachPartTwo()
+void Grammar::mf_GreibachPartTwo(const std::vector<Symbol>& order)
 {
-	auto vn = mf_ConvertVectorOfCharsToUset(m_nonterminalSymbols);
-	for (size_t i = 0; i < m_productions.size(); ++i) {
-		if(m_productions[i].first[0]==m_startSymbol && m_productions[i].second.size()>1 && vn.count(m_productions[i].second[0])) {
-			mf_GreibachFirstLema(i, 0);
+	const std::vector<size_t> rank = mf_GreibachRanks(order);
+	for (size_t i = order.size(); i > 0; --i) {
+		mf_GreibachSubstituteLeadingNonterminals(order[i - 1], rank, order.size());
+	}
+}
+void Grammar::mf_GreibachPartThree(const std::vector<Symbol>& order)
+{
+	const std::vector<size_t> rank = mf_GreibachRanks(order);
+	for (Symbol nonterminal : m_nonterminalSymbols) {
+		if (nonterminal >= rank.size() || rank[nonterminal] == order.size()) {
+			mf_GreibachSubstituteLeadingNonterminals(nonterminal, rank, order.size());
 		}
 	}
 }
-void Grammar::mf_GreibachPartThree()
+void Grammar::mf_GreibachSubstituteLeadingNonterminals(Symbol nonterminal, const std::vector<size_t>& rank, size_t maxRank)
 {
-	auto vn = mf_ConvertVectorOfCharsToUset(m_nonterminalSymbols);
-	for (size_t i = 0; i < m_productions.size(); ++i) {
-		if ((m_productions[i].first[0] >= 33 && m_productions[i].first[0]<=64) &&
-			vn.count(m_productions[i].second[0])) {
+	// The production stays on the same place of the index until its leading symbol is a terminal or ranks
+	// at least maxRank; when it is removed another production of the nonterminal takes that place.
+	size_t k = 0;
+	while (k < mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(nonterminal).size()) {
+		const size_t i = m_productionsByLeft[nonterminal][k];
+		const Symbol leading = m_productions[i].second[0];
+		if (leading < rank.size() && rank[leading] < maxRank) {
 			mf_GreibachFirstLema(i, 0);
+			continue;
 		}
+		++k;
+	}
+}
+std::vector<size_t> Grammar::mf_GreibachRanks(const std::vector<Symbol>& order) const
+{
+	// Symbols outside of order (terminals, lambda, the Z's) get order.size(), which is never below a maxRank.
+	std::vector<size_t> rank(m_symbolTable.Size(), order.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		rank[order[i]] = i;
 	}
+	return rank;
 }
 
 void Grammar::mf_GreibachFirstLema(size_t productionIndex, size_t symbolFromRightPartIndex)
 {
-	char symbolToBeReplaced = m_productions[productionIndex].second[symbolFromRightPartIndex];
-	bool firstModyfication = false;
-	std::string initialRightPartForm = m_productions[productionIndex].second;
-	for (size_t i = 0; i < m_productions.size(); ++i) {
-		if (m_productions[i].first == mf_ConvertCharToSizeOneString(symbolToBeReplaced)) {
-			if (!firstModyfication) {
-				mf_ApplyProductionOnString(i, symbolFromRightPartIndex, m_productions[productionIndex].second);
-				firstModyfication = true;
-				continue;
-			}
-			std::string newRightPart = initialRightPartForm;
-			mf_ApplyProductionOnString(i, symbolFromRightPartIndex, newRightPart);
-			m_productions.emplace_back(m_productions[productionIndex].first, newRightPart);
-		}
+	Symbol symbolToBeReplaced = m_productions[productionIndex].second[symbolFromRightPartIndex];
+	const std::vector<uint32_t> replacingProductions = mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(symbolToBeReplaced);
+	if (replacingProductions.empty()) {
+		mf_RemoveProduction(productionIndex);
+		return;
+	}
+	// Copied, as adding productions can move the symbols the views point to.
+	const Production initialProduction(m_productions[productionIndex].first, m_productions[productionIndex].second);
+	for (size_t i = 1; i < replacingProductions.size(); ++i) {
+		SymbolString newRightPart = initialProduction.second;
+		mf_ApplyProductionOnString(replacingProductions[i], symbolFromRightPartIndex, newRightPart);
+		mf_AddProduction(initialProduction.first, newRightPart);
 	}
+	SymbolString firstRightPart = initialProduction.second;
+	mf_ApplyProductionOnString(replacingProductions[0], symbolFromRightPartIndex, firstRightPart);
+	mf_SetProductionRightPart(productionIndex, firstRightPart);
 }
-void Grammar::mf_GreibachSecondLema(std::vector<size_t> recursiveProductionsIndexes, std::vector<size_t> nonrecursiveProductionsIndexes)
+void Grammar::mf_GreibachSecondLema(const std::vector<size_t>& recursiveProductionsIndexes, const std::vector<size_t>& nonrecursiveProductionsIndexes)
 {
-	std::vector<Production>newProductions;
-	for (size_t nonrecursiveIndex : nonrecursiveProductionsIndexes) {
-		std::string newZNonTerminal = mf_GetTheNextSymbolToBeAddedInProductions(newProductions, true);
-		m_nonterminalSymbols.push_back(newZNonTerminal[0]);
-		newProductions.emplace_back(m_productions[nonrecursiveIndex].first, m_productions[nonrecursiveIndex].second + newZNonTerminal);
-		newProductions.push_back(m_productions[nonrecursiveIndex]);
+	ProductionList newProductions;
+	if (!nonrecursiveProductionsIndexes.empty()) {
+		const SymbolString newZNonTerminal(1, mf_GetTheNextSymbolToBeAddedInProductions(true));
+		mf_AddNonterminal(newZNonTerminal[0]);
+		SymbolString rightPart;
+		for (size_t nonrecursiveIndex : nonrecursiveProductionsIndexes) {
+			const auto [left, right] = m_productions[nonrecursiveIndex];
+			rightPart.assign(right);
+			newProductions.Add(left, rightPart + newZNonTerminal);
+			newProductions.Add(left, right);
+		}
 		for (size_t recursiveIndex : recursiveProductionsIndexes) {
-			std::string rightPartWithoutFirstCharcter = m_productions[recursiveIndex].second.substr(1);
-			newProductions.emplace_back(newZNonTerminal, rightPartWithoutFirstCharcter);
-			newProductions.emplace_back(newZNonTerminal, rightPartWithoutFirstCharcter + newZNonTerminal);
+			const SymbolStringView rightPartWithoutFirstCharcter = m_productions[recursiveIndex].second.substr(1);
+			if (rightPartWithoutFirstCharcter.empty()) {
+				continue;
+			}
+			rightPart.assign(rightPartWithoutFirstCharcter);
+			newProductions.Add(newZNonTerminal, rightPart);
+			newProductions.Add(newZNonTerminal, rightPart + newZNonTerminal);
 		}
 	}
-	std::unordered_set<size_t>recursiveUset(std::begin(recursiveProductionsIndexes), std::end(recursiveProductionsIndexes));
-	std::unordered_set<size_t>nonrecursiveUset(std::begin(nonrecursiveProductionsIndexes), std::end(nonrecursiveProductionsIndexes));
-	for (size_t i = 0; i < m_productions.size(); ++i) {
-		if (recursiveUset.count(i) || nonrecursiveUset.count(i)) {
-			continue;
-		}
-		newProductions.push_back(m_productions[i]);
+	// Removed from the highest index down, so a production moved into a freed index is never one to remove.
+	std::vector<size_t> removedIndexes = recursiveProductionsIndexes;
+	removedIndexes.insert(removedIndexes.end(), nonrecursiveProductionsIndexes.begin(), nonrecursiveProductionsIndexes.end());
+	std::sort(removedIndexes.begin(), removedIndexes.end(), std::greater<size_t>());
+	for (size_t removedIndex : removedIndexes) {
+		mf_RemoveProduction(removedIndex);
 	}
-	m_productions = newProductions;
-}
-
-bool Grammar::mf_ContainsOnlyTerminalsOrTerminalsAndNonterminalsFromUset(const std::string& string, const std::unordered_set<std::string>& uSet) const
-{
-	auto vt = mf_ConvertVectorOfCharsToUset(m_terminalSymbols);
-	for (char character : string) {
-		if (!vt.count(character) && !uSet.count(mf_ConvertCharToSizeOneString(character))) {
-			return false;
-		}
+	for (const auto& [left, right] : newProductions) {
+		mf_AddProduction(left, right);
 	}
-	return true;
 }
 
-std::vector<std::string> Grammar::mf_GetAllNonterminalsFromString(const std::string& string) const
+
+std::vector<Grammar::Symbol> Grammar::mf_GetAllNonterminalsFromString(SymbolStringView string) const
 {
-	std::vector<std::string> result;
-	auto vn = mf_ConvertVectorOfCharsToUset(m_nonterminalSymbols);
-	for (char character : string)
+	std::vector<Symbol> result;
+	for (Symbol symbol : string)
 	{
-		if (vn.count(character)) {
-			result.push_back(mf_ConvertCharToSizeOneString(character));
+		if (mf_IsNonterminal(symbol)) {
+			result.push_back(symbol);
 		}
 	}
 	return result;
 }
 
-int Grammar::mf_GetRandom(const size_t& leftBound, const size_t& rightBound) const
+size_t Grammar::mf_GetRandom(const size_t& leftBound, const size_t& rightBound, RandomEngine& engine) const
 {
-	std::random_device rd;
-	std::mt19937 eng(rd());
-	std::uniform_int_distribution<> distr(leftBound, rightBound);
-	return distr(eng);
+	return engine.NextInRange(leftBound, rightBound);
 }
 
-std::string Grammar::mf_ReturnNonTerminalThatGoesOnlyInTerminal(const std::vector<Production>& productions, char character) const
-{
-	std::vector<Production> allProductionsThatGoesIntoCharacter;
-	std::unordered_map<std::string, unsigned int> nonTerminalApparitions;
 
-	for (const auto& production : productions) {
-		if (nonTerminalApparitions.count(production.first)) {
-			++nonTerminalApparitions[production.first];
-		}
-		else {
-			nonTerminalApparitions[production.first] = 1;
-		}
-		if (production.second.size() == 1) {
-			if (production.second[0] == character) {
-				allProductionsThatGoesIntoCharacter.push_back(production);
-			}
-		}
-	}
-	for (const auto& production : m_productions) {
-		if (nonTerminalApparitions.count(production.first)) {
-			++nonTerminalApparitions[production.first];
-		}
-		else {
-			nonTerminalApparitions[production.first] = 1;
-		}
-		if (production.second.size() == 1) {
-			if (production.second[0] == character) {
-				allProductionsThatGoesIntoCharacter.push_back(production);
-			}
-		}
-	}
-	for (const auto& production : allProductionsThatGoesIntoCharacter) {
-		if (nonTerminalApparitions[production.first] == 1) {
-			return production.first;
-		}
-	}
-	return {};
-}
-
-std::unordered_set<std::string> Grammar::mf_ConvertProductionsLeftPartToUSet(const std::vector<Production>& productions) const
-{
-	std::unordered_set<std::string> result;
-	for (const auto& production : productions) {
-		result.insert(production.first);
-	}
-	return result;
-}
 
-std::string Grammar::mf_GetTheNextSymbolToBeAddedInProductions(const std::vector<Production>& productions, bool getZ) const
+Grammar::Symbol Grammar::mf_GetTheNextSymbolToBeAddedInProductions(bool getZ)
 {
-	auto leftPartOfProductions = mf_ConvertProductionsLeftPartToUSet(productions);
-	for (const auto& production : m_productions) {
-		leftPartOfProductions.insert(production.first);
-	}
+	auto isUsed = [this](Symbol symbol) {
+		return symbol == SymbolTable::kNoSymbol
+			? false
+			: symbol == kLambdaSymbol || mf_IsNonterminal(symbol) || mf_IsTerminal(symbol) || !mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(symbol).empty();
+	};
 
-	if (getZ) {
-		for (char character = 33; character <= 64; ++character) {
-			if (leftPartOfProductions.count(mf_ConvertCharToSizeOneString(character))) {
-				continue;
-			}
-			return mf_ConvertCharToSizeOneString(character);
+	// Single characters are preferred while free; past them the names become X1, X2, ... (Z1, Z2, ...).
+	const char firstCharacter = getZ ? 33 : 'A';
+	const char lastCharacter = getZ ? 64 : 'Z';
+	for (char character = firstCharacter; character <= lastCharacter; ++character) {
+		if (!isUsed(m_symbolTable.Find(std::string(1, character)))) {
+			return m_symbolTable.Intern(std::string(1, character));
 		}
 	}
-	else {
-		for (char character = 'A'; character <= 'Z'; ++character) {
-			if (leftPartOfProductions.count(mf_ConvertCharToSizeOneString(character))) {
-				continue;
-			}
-			return mf_ConvertCharToSizeOneString(character);
+	for (size_t i = 1; ; ++i) {
+		const std::string name = (getZ ? "Z" : "X") + std::to_string(i);
+		if (!isUsed(m_symbolTable.Find(name))) {
+			return m_symbolTable.Intern(name);
 		}
 	}
-	return {};
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include <fstream>
 #include <iostream>
@@ -7,8 +8,21 @@
 #include <random>
 #include <cstdint>
 #include<unordered_map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
 
 #include "DerivationTree.h"
+#include "ProductionList.h"
+#include "RandomEngine.h"
+#include "SymbolTable.h"
+
+class SententialForm;
+class WordSampler;
+class LanguageEnumerator;
+class GrammarScanner;
+class MappedFile;
 
 class Grammar
 {
@@ -22,36 +36,92 @@ public:
 		Invalid
 	};
 
+public:
+	using Symbol = SymbolTable::Symbol;
+	using SymbolString = SymbolTable::SymbolString;
+	using SymbolStringView = SymbolTable::SymbolStringView;
+	using Production = std::pair<SymbolString, SymbolString>;
+
 public:
 	static const char kLambda = '_';
+	static constexpr Symbol kLambdaSymbol = 0; // the first symbol interned by every grammar
+	static constexpr size_t kNoProduction = SIZE_MAX;
+	static constexpr size_t kWordsPerFileBatch = 1 << 20;
+	static constexpr size_t kEnumerationMemoryLimit = 64 << 20; // bytes of distinct words held before spilling to disk
 
 public:
-	using Production = std::pair<std::string, std::string>;
+	struct VerificationError
+	{
+		size_t production; // kNoProduction when the error is about the whole grammar
+		const char* message;
+	};
+
+	class GeneratedWords // all the words in one buffer, word i is [offsets[i], offsets[i + 1])
+	{
+	public:
+		size_t GetWordsCount() const;
+		std::string_view GetWord(size_t index) const;
+		const std::string& GetCharacters() const;
+		const std::vector<size_t>& GetOffsets() const;
+
+	private:
+		friend class Grammar;
+
+	private:
+		std::string m_characters;
+		std::vector<size_t> m_offsets;
+	};
 
 public:
 	Grammar();
 	Grammar(std::ifstream& in);
 	Grammar(const Grammar& grammar);
+	Grammar(Grammar&& grammar) noexcept;
 
 public:
 	Grammar& operator=(const Grammar& grammar);
+	Grammar& operator=(Grammar&& grammar) noexcept;
 	bool operator==(const Grammar& grammar) const;
 	friend std::ostream& operator<<(std::ostream& os, const Grammar& grammar); // 3 Print
 
 public:
 	const Type& GetType() const;
+	const std::vector<Symbol>& GetNonterminalSymbols() const;
+	const std::vector<Symbol>& GetTerminalSymbols() const;
+	Symbol GetStartSymbol() const;
+	const ProductionList& GetProductions() const;
+	const SymbolTable& GetSymbolTable() const;
+	const std::vector<VerificationError>& GetVerificationErrors() const; // filled by Verify
 
 public:
-	void ReadFile(std::ifstream& in); // 1 Read
+	void ReadFile(std::ifstream& in); // 1 Read, the stream is left open
+	void ReadText(std::string_view text); // count-prefixed or BNF; throws GrammarScanner::Error with the line and column of the problem
+	void ReadMappedFile(const std::string& path);
 	void Verify(); // 2 Verify
 	bool VerifyVoidLanguage() const;
 
+public:
+	void SaveBinary(std::ostream& out) const; // see BinaryFormat, out must be opened in binary mode
+	void SaveBinary(const std::string& path) const;
+	void LoadBinary(std::span<const uint8_t> bytes);
+	void LoadBinary(const std::string& path); // mapped and read in place; nothing is parsed, verified, normalized or indexed again
+
 public:
 	std::string GenerateWord() const; // 4 Generate
+	std::string GenerateWord(RandomEngine& engine) const;
 	std::vector<std::string> GenerateWords(int amount = 1) const; // 4 Generate
+	std::vector<std::string> GenerateWords(int amount, uint64_t seed) const; // the same words for the same seed
+	GeneratedWords GenerateWordsParallel(size_t amount, uint64_t seed) const; // same words and order as GenerateWords(amount, seed)
+	void GenerateWordsToFile(size_t amount, uint64_t seed, std::ostream& out) const; // one word per line
+	WordSampler CreateWordSampler(size_t maxLength) const; // words of uniformly drawn derivation trees of a chosen length, see WordSampler
+	LanguageEnumerator EnumerateLanguage(size_t maxLength, size_t memoryLimit = kEnumerationMemoryLimit) const; // distinct words in shortlex order
+
+public:
+	std::vector<uint64_t> GeneratesAll(std::span<const std::string> words) const; // bit i of the result is set if words[i] is in the language
 
 public:
 	void PrintWord() const;
+	void PrintVerificationErrors() const;
 	void PrintWords(int amount = 1) const;
 
 public:
@@ -60,51 +130,101 @@ public:
 	void MakeItGreibach();
 
 private:
-	bool mf_VerifyIntersection() const;
-	bool mf_VerifyStartSymbol() const;
-	bool mf_VerifyAtLeastOneNonterminalInProductionLeft() const;
-	bool mf_VerifyProductions() const;
+	friend class GrammarEditor;
+
+private:
+	void mf_ReadBnf(GrammarScanner& scanner);
+	void mf_LoadBinary(std::span<const uint8_t> bytes, std::shared_ptr<const MappedFile> image);
+
+private:
+	void mf_VerifyIntersection();
+	void mf_VerifyStartSymbol();
+	Type mf_VerifyProduction(size_t productionIndex, bool symbolsAreKnown = false);
+	bool mf_AllSymbolsAreKnown() const; // every symbol in the production store is terminal, nonterminal or lambda
 	
 private:
-	bool mf_StringContainsAtLeastOneElementFromTheSet(const std::string& string, const std::unordered_set<char>& set) const;
-	std::unordered_set<char> mf_ConvertVectorOfCharsToUset(const std::vector<char>& vector) const;
-	std::vector<char> mf_ConvertUsetOfStringsToVectorOfChars(const std::unordered_set<std::string>& uSet) const;
-	std::vector<int> mf_GetSubstrPositionsInString(const std::string& substr, const std::string& string) const;
-	void mf_ApplyProductionOnString(int productionIndex, int positionInString, std::string& string) const;
-	void mf_AddChildrensFromStringToNode(DerivationTree::Node* node, const std::string& string) const;
-	bool mf_ContainsOnlyTerminals(const std::string& string) const;
-	std::string mf_ConvertCharToSizeOneString(char character) const;
-	std::unordered_set<std::string> mf_GetDifferenceBetweenCurrentNonterminalsAndNewNonterminals(const std::unordered_set<std::string>& newNonterminals) const;
-	std::vector<size_t> mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(const std::string& nonterminal) const;
-	bool mf_ContainsOnlyTerminalsOrTerminalsAndNonterminalsFromUset(const std::string& string, const std::unordered_set<std::string>& uSet) const;
-	std::vector<std::string> mf_GetAllNonterminalsFromString(const std::string& string) const;
-	int mf_GetRandom(const size_t& leftBound, const size_t& rightBound) const;
-	std::string mf_ReturnNonTerminalThatGoesOnlyInTerminal(const std::vector<Production>& productions, char character) const;
-	std::unordered_set<std::string> mf_ConvertProductionsLeftPartToUSet(const std::vector<Production>& productions) const;
-	std::string mf_GetTheNextSymbolToBeAddedInProductions(const std::vector<Production>& productions, bool getZ = false) const;
+	bool mf_StringContainsAtLeastOneElementFromTheSet(SymbolStringView string, const std::vector<bool>& set) const;
+	std::vector<bool> mf_ConvertSymbolsToBitset(const std::vector<Symbol>& symbols) const;
+	void mf_UpdateSymbolSets(); // after m_nonterminalSymbols or m_terminalSymbols are reassigned
+	void mf_AddNonterminal(Symbol symbol);
+	bool mf_IsNonterminal(Symbol symbol) const;
+	bool mf_IsTerminal(Symbol symbol) const;
+	std::vector<int> mf_GetSubstrPositionsInString(SymbolStringView substr, SymbolStringView string) const;
+	void mf_ApplyProductionOnString(int productionIndex, int positionInString, SymbolString& string) const;
+	bool mf_ContainsOnlyTerminals(SymbolStringView string) const;
+	std::vector<bool> mf_GetDifferenceBetweenCurrentNonterminalsAndNewNonterminals(const std::vector<bool>& newNonterminals) const;
+	const std::vector<uint32_t>& mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(Symbol nonterminal) const;
+	const std::vector<uint32_t>& mf_GetProductionsUsing(Symbol symbol) const; // one entry per occurrence in a right part
+	std::vector<bool> mf_GetProductiveNonterminals() const;
+	std::vector<Symbol> mf_GetAllNonterminalsFromString(SymbolStringView string) const;
+	size_t mf_GetRandom(const size_t& leftBound, const size_t& rightBound, RandomEngine& engine) const;
+	SententialForm mf_CreateSententialForm() const;
+	void mf_GenerateContextIndependentWord(RandomEngine& engine, SententialForm& form, std::string& word) const; // appends to word; only for context independent and regular grammars
+	void mf_GenerateWordsParallel(size_t begin, size_t end, uint64_t seed, GeneratedWords& words) const;
+	Symbol mf_GetTheNextSymbolToBeAddedInProductions(bool getZ = false);
+
+private:
+	void mf_InvalidateProductionIndexes(); // after m_productions is reassigned
+	void mf_EnsureProductionIndexes() const; // builds them on first use, once even when several threads ask
+	void mf_BuildProductionIndexes() const; // copied from m_savedProductionIndexes when there are some
+	void mf_IndexProduction(size_t productionIndex);
+	void mf_UnindexProduction(size_t productionIndex, bool leftPart, bool rightPart);
+	size_t mf_AddProduction(SymbolStringView left, SymbolStringView right);
+	void mf_RemoveProduction(size_t productionIndex); // the last production takes its index
+	void mf_SetProductionRightPart(size_t productionIndex, SymbolStringView rightPart);
 
 private:
+	void mf_RemoveLambdaProductions();
+	std::vector<bool> mf_GetNullableNonterminals() const;
+	void mf_ExpandNullableSymbols(SymbolStringView right, size_t position, const std::vector<bool>& isNullable, SymbolString& expansion, std::unordered_set<SymbolString>& expansions) const;
 	void mf_RemoveUnusableNonterminals();
 	void mf_RemoveUnaccesibleNonterminals();
 	void mf_RemoveRenames();
+	void mf_RemoveNonterminalsNotIn(const std::vector<bool>& newNonterminals);
 
 private:
 	void mf_ChomskyPartTwo();
 	void mf_ChomskyPartThree();
 
 private:
-	void mf_GreibachPartOne();
-	void mf_GreibachPartTwo();
-	void mf_GreibachPartThree();
+	void mf_GreibachPartOne(const std::vector<Symbol>& order);
+	void mf_GreibachPartTwo(const std::vector<Symbol>& order);
+	void mf_GreibachPartThree(const std::vector<Symbol>& order);
 
 private:
 	void mf_GreibachFirstLema(size_t productionIndex, size_t symbolFromRightPartIndex);
-	void mf_GreibachSecondLema(std::vector<size_t> recursiveProductionsIndexes, std::vector<size_t> nonrecursiveProductionsIndexes);
+	void mf_GreibachSecondLema(const std::vector<size_t>& recursiveProductionsIndexes, const std::vector<size_t>& nonrecursiveProductionsIndexes);
+	void mf_GreibachSubstituteLeadingNonterminals(Symbol nonterminal, const std::vector<size_t>& rank, size_t maxRank);
+	std::vector<size_t> mf_GreibachRanks(const std::vector<Symbol>& order) const;
 
 private:
-	std::vector<char> m_nonterminalSymbols;
-	std::vector<char> m_terminalSymbols;
-	char m_startSymbol;
-	std::vector<Production> m_productions;
+	SymbolTable m_symbolTable;
+	std::vector<Symbol> m_nonterminalSymbols;
+	std::vector<Symbol> m_terminalSymbols;
+	std::vector<bool> m_isNonterminal; // membership of m_nonterminalSymbols, indexed by symbol id
+	std::vector<bool> m_isTerminal; // membership of m_terminalSymbols, indexed by symbol id
+	Symbol m_startSymbol;
+	ProductionList m_productions;
+	mutable std::vector<std::vector<uint32_t>> m_productionsByLeft; // per symbol id, the productions having it in their left part
+	mutable std::vector<std::vector<uint32_t>> m_productionsByRight; // per symbol id, a production for every occurrence in a right part
+	mutable std::atomic<bool> m_productionIndexesAreBuilt;
+	mutable std::mutex m_productionIndexesMutex;
 	Type m_type;
+	std::vector<VerificationError> m_verificationErrors;
+
+private:
+	// The production indexes of a mapped binary image, the productions of symbol s at [offsets[s],
+	// offsets[s + 1]) of the entries. They are copied into m_productionsByLeft and m_productionsByRight
+	// the first time those are used.
+	struct SavedProductionIndexes
+	{
+		std::shared_ptr<const MappedFile> image;
+		std::span<const uint32_t> leftOffsets;
+		std::span<const uint32_t> leftEntries;
+		std::span<const uint32_t> rightOffsets;
+		std::span<const uint32_t> rightEntries;
+	};
+
+private:
+	SavedProductionIndexes m_savedProductionIndexes;
 };
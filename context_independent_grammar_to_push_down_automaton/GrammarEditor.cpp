@@ -0,0 +1,602 @@
+#include "GrammarEditor.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+GrammarEditor::GrammarEditor(const Grammar& grammar)
+	: m_grammar(grammar)
+	, m_separatePushedSymbols(false)
+	, m_recomputedCount(0)
+{
+	if (m_grammar.m_type != Grammar::Type::Regular && m_grammar.m_type != Grammar::Type::ContextIndependent) {
+		throw "The grammar is not context independent.";
+	}
+	for (Symbol symbol : m_grammar.m_nonterminalSymbols) {
+		mf_CheckName(m_grammar.m_symbolTable.GetName(symbol));
+	}
+	for (Symbol symbol : m_grammar.m_terminalSymbols) {
+		mf_CheckName(m_grammar.m_symbolTable.GetName(symbol));
+	}
+	for (const auto& [left, right] : m_grammar.m_productions) {
+		if (std::find(right.begin(), right.end(), Grammar::kLambdaSymbol) != right.end()) {
+			throw "The editor does not support lambda productions.";
+		}
+	}
+
+	mf_ResizeSymbolTables();
+	for (Symbol symbol : m_grammar.m_terminalSymbols) {
+		m_isProductive[symbol] = 1;
+	}
+	m_unproductiveCounts.reserve(m_grammar.m_productions.Size());
+	for (const auto& [left, right] : m_grammar.m_productions) {
+		m_unproductiveCounts.push_back(static_cast<uint32_t>(std::count_if(right.begin(), right.end(), [this](Symbol symbol) {
+			return m_grammar.mf_IsNonterminal(symbol);
+		})));
+	}
+	m_isProductionTouched.assign(m_grammar.m_productions.Size(), 0);
+	for (size_t i = 0; i < m_grammar.m_productions.Size(); ++i) {
+		if (m_unproductiveCounts[i] == 0) {
+			mf_MarkProductive(m_grammar.m_productions[i].first[0]);
+		}
+	}
+	m_isLive.resize(m_grammar.m_productions.Size());
+	for (size_t i = 0; i < m_grammar.m_productions.Size(); ++i) {
+		m_isLive[i] = m_unproductiveCounts[i] == 0;
+	}
+	if (m_grammar.m_startSymbol != SymbolTable::kNoSymbol) {
+		mf_MarkReachable(m_grammar.m_startSymbol);
+	}
+	mf_ClearTouched();
+
+	for (Symbol symbol : m_grammar.m_nonterminalSymbols) {
+		mf_RecomputeChomskyProductions(symbol);
+	}
+	m_recomputedCount = m_grammar.m_nonterminalSymbols.size();
+	mf_BuildAutomaton();
+}
+
+GrammarEditor::Symbol GrammarEditor::AddNonterminal(std::string_view name)
+{
+	mf_CheckName(name);
+	const Symbol symbol = m_grammar.m_symbolTable.Intern(name);
+	if (m_grammar.mf_IsNonterminal(symbol)) {
+		return symbol;
+	}
+	if (symbol == Grammar::kLambdaSymbol || m_grammar.mf_IsTerminal(symbol)) {
+		throw "The name is already used by another symbol.";
+	}
+	m_grammar.mf_AddNonterminal(symbol);
+	mf_ResizeSymbolTables();
+	m_recomputedCount = 0;
+	mf_BuildAutomaton();
+	return symbol;
+}
+
+GrammarEditor::Symbol GrammarEditor::AddTerminal(std::string_view name)
+{
+	mf_CheckName(name);
+	const Symbol symbol = m_grammar.m_symbolTable.Intern(name);
+	if (m_grammar.mf_IsTerminal(symbol)) {
+		return symbol;
+	}
+	if (symbol == Grammar::kLambdaSymbol || m_grammar.mf_IsNonterminal(symbol)) {
+		throw "The name is already used by another symbol.";
+	}
+	m_grammar.m_terminalSymbols.push_back(symbol);
+	m_grammar.mf_UpdateSymbolSets();
+	mf_ResizeSymbolTables();
+	m_isProductive[symbol] = 1;
+	m_recomputedCount = 0;
+	mf_BuildAutomaton();
+	return symbol;
+}
+
+bool GrammarEditor::AddProduction(const Production& production)
+{
+	const auto& [left, right] = production;
+	if (left.size() != 1 || !m_grammar.mf_IsNonterminal(left[0]) || right.empty()) {
+		throw "The production is not context independent.";
+	}
+	for (Symbol symbol : right) {
+		if (symbol == Grammar::kLambdaSymbol) {
+			throw "The editor does not support lambda productions.";
+		}
+		if (!m_grammar.mf_IsNonterminal(symbol) && !m_grammar.mf_IsTerminal(symbol)) {
+			throw "The production uses a symbol that is neither terminal nor nonterminal.";
+		}
+	}
+	if (mf_FindProduction(production) != Grammar::kNoProduction) {
+		return false;
+	}
+
+	const size_t productionIndex = m_grammar.mf_AddProduction(production.first, production.second);
+	m_grammar.m_type = std::max(m_grammar.m_type, m_grammar.mf_VerifyProduction(productionIndex));
+	m_unproductiveCounts.push_back(static_cast<uint32_t>(std::count_if(right.begin(), right.end(), [this](Symbol symbol) {
+		return m_grammar.mf_IsNonterminal(symbol) && !m_isProductive[symbol];
+	})));
+	m_isLive.push_back(0);
+	m_isProductionTouched.push_back(0);
+	mf_TouchProduction(productionIndex);
+	if (m_unproductiveCounts[productionIndex] == 0) {
+		mf_MarkProductive(left[0]);
+	}
+	mf_Update(left[0], {});
+	return true;
+}
+
+bool GrammarEditor::RemoveProduction(const Production& production)
+{
+	const size_t productionIndex = mf_FindProduction(production);
+	if (productionIndex == Grammar::kNoProduction) {
+		return false;
+	}
+	const Symbol left = production.first[0];
+	std::vector<Symbol> lostTargets;
+	if (m_isLive[productionIndex]) {
+		std::copy_if(production.second.begin(), production.second.end(), std::back_inserter(lostTargets), [this](Symbol symbol) {
+			return m_grammar.mf_IsNonterminal(symbol);
+		});
+	}
+
+	// The last production takes the freed index, as it does in the grammar.
+	m_grammar.mf_RemoveProduction(productionIndex);
+	m_unproductiveCounts[productionIndex] = m_unproductiveCounts.back();
+	m_unproductiveCounts.pop_back();
+	m_isLive[productionIndex] = m_isLive.back();
+	m_isLive.pop_back();
+	m_isProductionTouched.pop_back();
+
+	mf_RecheckProductive(left);
+	mf_Update(left, lostTargets);
+	return true;
+}
+
+const Grammar& GrammarEditor::GetGrammar() const
+{
+	return m_grammar;
+}
+
+bool GrammarEditor::IsProductive(Symbol nonterminal) const
+{
+	return nonterminal < m_isProductive.size() && m_isProductive[nonterminal];
+}
+
+bool GrammarEditor::IsReachable(Symbol nonterminal) const
+{
+	return nonterminal < m_isReachable.size() && m_isReachable[nonterminal];
+}
+
+bool GrammarEditor::IsUseful(Symbol nonterminal) const
+{
+	return IsProductive(nonterminal) && IsReachable(nonterminal);
+}
+
+Grammar GrammarEditor::GetChomskyGrammar() const
+{
+	Grammar chomsky;
+	chomsky.m_symbolTable = m_grammar.m_symbolTable;
+	chomsky.m_terminalSymbols = m_grammar.m_terminalSymbols;
+	chomsky.m_startSymbol = m_grammar.m_startSymbol;
+
+	std::vector<uint8_t> isListed(m_grammar.m_symbolTable.Size(), 0);
+	auto addNonterminal = [&chomsky, &isListed](Symbol symbol) {
+		if (!isListed[symbol]) {
+			isListed[symbol] = 1;
+			chomsky.m_nonterminalSymbols.push_back(symbol);
+		}
+	};
+	if (m_grammar.m_startSymbol != SymbolTable::kNoSymbol) {
+		addNonterminal(m_grammar.m_startSymbol);
+	}
+	for (Symbol nonterminal : m_grammar.m_nonterminalSymbols) {
+		for (const Production& production : m_chomskyProductions[nonterminal]) {
+			addNonterminal(production.first[0]);
+			chomsky.m_productions.Add(production.first, production.second);
+			for (Symbol symbol : production.second) {
+				const Symbol terminal = m_wrappedTerminals[symbol];
+				if (terminal != SymbolTable::kNoSymbol && !isListed[symbol]) {
+					addNonterminal(symbol);
+					chomsky.m_productions.Add(SymbolString(1, symbol), SymbolString(1, terminal));
+				}
+			}
+		}
+	}
+	chomsky.mf_UpdateSymbolSets();
+	chomsky.mf_InvalidateProductionIndexes();
+	chomsky.Verify();
+	return chomsky;
+}
+
+const PushDownAutomaton& GrammarEditor::GetAutomaton() const
+{
+	return m_automaton;
+}
+
+size_t GrammarEditor::GetRecomputedCount() const
+{
+	return m_recomputedCount;
+}
+
+void GrammarEditor::mf_CheckName(std::string_view name) const
+{
+	if (name.empty() || std::any_of(name.begin(), name.end(), [](char character) { return character == ' ' || (character >= '\t' && character <= '\r'); })) {
+		throw "A symbol name cannot be empty or contain white space.";
+	}
+	if (name.find(kGeneratedNameMark) != std::string_view::npos) {
+		throw "The names of the normal form symbols are reserved.";
+	}
+}
+
+size_t GrammarEditor::mf_FindProduction(const Production& production) const
+{
+	if (production.first.size() != 1) {
+		return Grammar::kNoProduction;
+	}
+	for (size_t productionIndex : m_grammar.mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(production.first[0])) {
+		const auto [left, right] = m_grammar.m_productions[productionIndex];
+		if (left == production.first && right == production.second) {
+			return productionIndex;
+		}
+	}
+	return Grammar::kNoProduction;
+}
+
+void GrammarEditor::mf_Update(Symbol left, const std::vector<Symbol>& lostTargets)
+{
+	// Reachability follows the productions whose liveness changed: the targets of the lost ones are
+	// checked again, the gained ones propagate from a reachable left part.
+	std::vector<Symbol> lost = lostTargets;
+	std::vector<size_t> gained;
+	std::vector<Symbol> unitRoots{ left };
+	for (size_t productionIndex : m_touchedProductions) {
+		const bool live = m_unproductiveCounts[productionIndex] == 0;
+		if (live == static_cast<bool>(m_isLive[productionIndex])) {
+			continue;
+		}
+		m_isLive[productionIndex] = live;
+		const auto& [productionLeft, right] = m_grammar.m_productions[productionIndex];
+		unitRoots.push_back(productionLeft[0]);
+		if (live) {
+			gained.push_back(productionIndex);
+		}
+		else {
+			std::copy_if(right.begin(), right.end(), std::back_inserter(lost), [this](Symbol symbol) {
+				return m_grammar.mf_IsNonterminal(symbol);
+			});
+		}
+	}
+	mf_RecheckReachable(lost);
+	for (size_t productionIndex : gained) {
+		const auto& [productionLeft, right] = m_grammar.m_productions[productionIndex];
+		if (m_isReachable[productionLeft[0]]) {
+			for (Symbol symbol : right) {
+				if (m_grammar.mf_IsNonterminal(symbol)) {
+					mf_MarkReachable(symbol);
+				}
+			}
+		}
+	}
+
+	// The normal form of A changes with A's usefulness and with the live productions of the nonterminals
+	// A reaches through live unit productions.
+	std::vector<Symbol> dirty;
+	auto addDirty = [this, &dirty](Symbol symbol) {
+		if (!m_isDirty[symbol]) {
+			m_isDirty[symbol] = 1;
+			dirty.push_back(symbol);
+		}
+	};
+	for (const auto& [symbol, wasUseful] : m_touchedSymbols) {
+		if (IsUseful(symbol) != wasUseful) {
+			addDirty(symbol);
+		}
+	}
+	for (Symbol root : unitRoots) {
+		addDirty(root);
+	}
+	for (size_t i = 0; i < dirty.size(); ++i) {
+		for (size_t productionIndex : m_grammar.mf_GetProductionsUsing(dirty[i])) {
+			const auto& [productionLeft, right] = m_grammar.m_productions[productionIndex];
+			if (m_isLive[productionIndex] && right.size() == 1) {
+				addDirty(productionLeft[0]);
+			}
+		}
+	}
+	for (Symbol symbol : dirty) {
+		m_isDirty[symbol] = 0;
+		mf_RecomputeChomskyProductions(symbol);
+	}
+	m_recomputedCount = dirty.size();
+
+	m_automaton.ReplaceTransitions(m_automaton.m_initialState, m_grammar.m_symbolTable.GetName(left), mf_GetTransitions(left));
+	mf_ClearTouched();
+}
+
+void GrammarEditor::mf_SetProductive(Symbol symbol, bool productive)
+{
+	mf_TouchSymbol(symbol);
+	m_isProductive[symbol] = productive;
+	for (size_t productionIndex : m_grammar.mf_GetProductionsUsing(symbol)) {
+		if (productive) {
+			--m_unproductiveCounts[productionIndex];
+		}
+		else {
+			++m_unproductiveCounts[productionIndex];
+		}
+		mf_TouchProduction(productionIndex);
+	}
+}
+
+void GrammarEditor::mf_MarkProductive(Symbol symbol)
+{
+	if (m_isProductive[symbol]) {
+		return;
+	}
+	mf_SetProductive(symbol, true);
+	std::vector<Symbol> worklist{ symbol };
+	while (!worklist.empty()) {
+		const Symbol productive = worklist.back();
+		worklist.pop_back();
+		for (size_t productionIndex : m_grammar.mf_GetProductionsUsing(productive)) {
+			const Symbol left = m_grammar.m_productions[productionIndex].first[0];
+			if (m_unproductiveCounts[productionIndex] == 0 && !m_isProductive[left]) {
+				mf_SetProductive(left, true);
+				worklist.push_back(left);
+			}
+		}
+	}
+}
+
+void GrammarEditor::mf_RecheckProductive(Symbol symbol)
+{
+	// Everything that was productive through a live production using a dropped nonterminal is dropped
+	// too; what still has a production of productive symbols is then marked again.
+	if (!m_isProductive[symbol]) {
+		return;
+	}
+	mf_SetProductive(symbol, false);
+	std::vector<Symbol> dropped{ symbol };
+	for (size_t i = 0; i < dropped.size(); ++i) {
+		for (size_t productionIndex : m_grammar.mf_GetProductionsUsing(dropped[i])) {
+			const Symbol left = m_grammar.m_productions[productionIndex].first[0];
+			if (m_isLive[productionIndex] && m_isProductive[left]) {
+				mf_SetProductive(left, false);
+				dropped.push_back(left);
+			}
+		}
+	}
+	for (Symbol nonterminal : dropped) {
+		for (size_t productionIndex : m_grammar.mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(nonterminal)) {
+			if (m_unproductiveCounts[productionIndex] == 0) {
+				mf_MarkProductive(nonterminal);
+				break;
+			}
+		}
+	}
+}
+
+void GrammarEditor::mf_SetReachable(Symbol symbol, bool reachable)
+{
+	mf_TouchSymbol(symbol);
+	m_isReachable[symbol] = reachable;
+}
+
+void GrammarEditor::mf_MarkReachable(Symbol symbol)
+{
+	if (m_isReachable[symbol]) {
+		return;
+	}
+	mf_SetReachable(symbol, true);
+	std::vector<Symbol> worklist{ symbol };
+	while (!worklist.empty()) {
+		const Symbol reachable = worklist.back();
+		worklist.pop_back();
+		for (size_t productionIndex : m_grammar.mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(reachable)) {
+			if (!m_isLive[productionIndex]) {
+				continue;
+			}
+			for (Symbol right : m_grammar.m_productions[productionIndex].second) {
+				if (m_grammar.mf_IsNonterminal(right) && !m_isReachable[right]) {
+					mf_SetReachable(right, true);
+					worklist.push_back(right);
+				}
+			}
+		}
+	}
+}
+
+void GrammarEditor::mf_RecheckReachable(const std::vector<Symbol>& symbols)
+{
+	// Everything reachable from the given nonterminals is dropped, then marked again from the live
+	// productions that still lead to it from a reachable left part.
+	std::vector<Symbol> dropped;
+	auto drop = [this, &dropped](Symbol symbol) {
+		if (m_isReachable[symbol] && symbol != m_grammar.m_startSymbol) {
+			mf_SetReachable(symbol, false);
+			dropped.push_back(symbol);
+		}
+	};
+	for (Symbol symbol : symbols) {
+		drop(symbol);
+	}
+	for (size_t i = 0; i < dropped.size(); ++i) {
+		for (size_t productionIndex : m_grammar.mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(dropped[i])) {
+			if (m_isLive[productionIndex]) {
+				for (Symbol right : m_grammar.m_productions[productionIndex].second) {
+					if (m_grammar.mf_IsNonterminal(right)) {
+						drop(right);
+					}
+				}
+			}
+		}
+	}
+	for (Symbol symbol : dropped) {
+		for (size_t productionIndex : m_grammar.mf_GetProductionsUsing(symbol)) {
+			if (m_isLive[productionIndex] && m_isReachable[m_grammar.m_productions[productionIndex].first[0]]) {
+				mf_MarkReachable(symbol);
+				break;
+			}
+		}
+	}
+}
+
+void GrammarEditor::mf_TouchSymbol(Symbol symbol)
+{
+	if (!m_isSymbolTouched[symbol]) {
+		m_isSymbolTouched[symbol] = 1;
+		m_touchedSymbols.emplace_back(symbol, IsUseful(symbol));
+	}
+}
+
+void GrammarEditor::mf_TouchProduction(size_t productionIndex)
+{
+	if (!m_isProductionTouched[productionIndex]) {
+		m_isProductionTouched[productionIndex] = 1;
+		m_touchedProductions.push_back(productionIndex);
+	}
+}
+
+void GrammarEditor::mf_ClearTouched()
+{
+	for (const auto& [symbol, wasUseful] : m_touchedSymbols) {
+		m_isSymbolTouched[symbol] = 0;
+	}
+	for (size_t productionIndex : m_touchedProductions) {
+		m_isProductionTouched[productionIndex] = 0;
+	}
+	m_touchedSymbols.clear();
+	m_touchedProductions.clear();
+}
+
+void GrammarEditor::mf_ResizeSymbolTables()
+{
+	const size_t symbolsCount = m_grammar.m_symbolTable.Size();
+	m_isProductive.resize(symbolsCount, 0);
+	m_isReachable.resize(symbolsCount, 0);
+	m_chomskyProductions.resize(symbolsCount);
+	m_wrappedTerminals.resize(symbolsCount, SymbolTable::kNoSymbol);
+	m_isSymbolTouched.resize(symbolsCount, 0);
+	m_isDirty.resize(symbolsCount, 0);
+	m_isInClosure.resize(symbolsCount, 0);
+}
+
+void GrammarEditor::mf_RecomputeChomskyProductions(Symbol nonterminal)
+{
+	std::vector<Production> productions;
+	if (!IsUseful(nonterminal)) {
+		m_chomskyProductions[nonterminal] = std::move(productions);
+		return;
+	}
+
+	// A takes the other productions of every nonterminal it reaches through live unit productions, so no
+	// unit production is kept.
+	std::vector<Symbol> closure{ nonterminal };
+	m_isInClosure[nonterminal] = 1;
+	for (size_t i = 0; i < closure.size(); ++i) {
+		for (size_t productionIndex : m_grammar.mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(closure[i])) {
+			const SymbolStringView right = m_grammar.m_productions[productionIndex].second;
+			if (m_isLive[productionIndex] && right.size() == 1 && m_grammar.mf_IsNonterminal(right[0]) && !m_isInClosure[right[0]]) {
+				m_isInClosure[right[0]] = 1;
+				closure.push_back(right[0]);
+			}
+		}
+	}
+
+	// A ---> X1...Xn becomes A ---> X1 A'1, A'1 ---> X2 A'2, ..., A'k ---> X(n-1) Xn, with every terminal a
+	// replaced by 'a. The chain names depend only on A, so recomputing A reuses its symbols.
+	const std::string name = m_grammar.m_symbolTable.GetName(nonterminal);
+	size_t chainsCount = 0;
+	for (Symbol symbol : closure) {
+		m_isInClosure[symbol] = 0;
+		for (size_t productionIndex : m_grammar.mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(symbol)) {
+			if (!m_isLive[productionIndex]) {
+				continue;
+			}
+			const SymbolString right(m_grammar.m_productions[productionIndex].second);
+			if (right.size() == 1) {
+				if (m_grammar.mf_IsTerminal(right[0])) {
+					productions.emplace_back(SymbolString(1, nonterminal), right);
+				}
+				continue;
+			}
+			Symbol chainLeft = nonterminal;
+			for (size_t i = 0; i + 1 < right.size(); ++i) {
+				const Symbol first = m_grammar.mf_IsTerminal(right[i]) ? mf_GetWrapper(right[i]) : right[i];
+				Symbol second;
+				if (i + 2 == right.size()) {
+					second = m_grammar.mf_IsTerminal(right[i + 1]) ? mf_GetWrapper(right[i + 1]) : right[i + 1];
+				}
+				else {
+					second = m_grammar.m_symbolTable.Intern(name + kGeneratedNameMark + std::to_string(++chainsCount));
+					mf_ResizeSymbolTables();
+				}
+				productions.emplace_back(SymbolString(1, chainLeft), SymbolString{ first, second });
+				chainLeft = second;
+			}
+		}
+	}
+	std::sort(productions.begin(), productions.end());
+	productions.erase(std::unique(productions.begin(), productions.end()), productions.end());
+	m_chomskyProductions[nonterminal] = std::move(productions);
+}
+
+GrammarEditor::Symbol GrammarEditor::mf_GetWrapper(Symbol terminal)
+{
+	const Symbol wrapper = m_grammar.m_symbolTable.Intern(kGeneratedNameMark + m_grammar.m_symbolTable.GetName(terminal));
+	mf_ResizeSymbolTables();
+	m_wrappedTerminals[wrapper] = terminal;
+	return wrapper;
+}
+
+std::unordered_map<std::string, PushDownAutomaton::DeltaResult> GrammarEditor::mf_GetTransitions(Symbol nonterminal) const
+{
+	// A ---> aX1...Xn reads a and replaces A by X1...Xn, A ---> X1...Xn replaces A without reading;
+	// terminals on the stack are popped by reading them.
+	const std::string lambda(1, PushDownAutomaton::kLambda);
+	const std::string& state = m_automaton.m_initialState;
+	std::unordered_map<std::string, PushDownAutomaton::DeltaResult> results;
+	for (size_t productionIndex : m_grammar.mf_ReturnAllProductionIndexesThatHaveNonterminalInLeft(nonterminal)) {
+		const SymbolStringView right = m_grammar.m_productions[productionIndex].second;
+		const bool reads = m_grammar.mf_IsTerminal(right[0]);
+		std::string pushedString;
+		for (size_t i = reads ? 1 : 0; i < right.size(); ++i) {
+			if (m_separatePushedSymbols && !pushedString.empty()) {
+				pushedString.push_back(' ');
+			}
+			pushedString += m_grammar.m_symbolTable.GetName(right[i]);
+		}
+		results[reads ? m_grammar.m_symbolTable.GetName(right[0]) : lambda].emplace_back(state, pushedString.empty() ? lambda : pushedString);
+	}
+	return results;
+}
+
+void GrammarEditor::mf_BuildAutomaton()
+{
+	const std::string lambda(1, PushDownAutomaton::kLambda);
+	PushDownAutomaton automaton;
+	automaton.m_initialState = "q";
+	automaton.m_states.insert(automaton.m_initialState);
+	for (Symbol symbol : m_grammar.m_terminalSymbols) {
+		const std::string& name = m_grammar.m_symbolTable.GetName(symbol);
+		automaton.m_alphabet.insert(name);
+		automaton.m_stackAlphabet.insert(name);
+		automaton.m_delta[automaton.m_initialState][name][name].emplace_back(automaton.m_initialState, lambda);
+	}
+	for (Symbol symbol : m_grammar.m_nonterminalSymbols) {
+		automaton.m_stackAlphabet.insert(m_grammar.m_symbolTable.GetName(symbol));
+	}
+	if (m_grammar.m_startSymbol != SymbolTable::kNoSymbol) {
+		automaton.m_stackStartSymbol = m_grammar.m_symbolTable.GetName(m_grammar.m_startSymbol);
+	}
+	m_separatePushedSymbols = std::any_of(automaton.m_stackAlphabet.begin(), automaton.m_stackAlphabet.end(), [](const std::string& name) {
+		return name.size() != 1;
+	});
+	m_automaton = std::move(automaton);
+	for (Symbol symbol : m_grammar.m_nonterminalSymbols) {
+		auto results = mf_GetTransitions(symbol);
+		if (!results.empty()) {
+			m_automaton.m_delta[m_automaton.m_initialState][m_grammar.m_symbolTable.GetName(symbol)] = std::move(results);
+		}
+	}
+	m_automaton.mf_CompileTransitions();
+}
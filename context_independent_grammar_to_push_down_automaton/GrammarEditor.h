@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Grammar.h"
+#include "PushDownAutomaton.h"
+
+// Edits a context independent grammar one production at a time and keeps what is derived from it up to
+// date: the productive and reachable nonterminals, a Chomsky normal form and a compiled automaton.
+//
+// A production is live when every nonterminal of its right part is productive; reachability follows live
+// productions only, and a nonterminal is useful when it is both productive and reachable. Adding a
+// production propagates forward from it; removing one first drops everything that may have rested on
+// it and then marks again what still holds. The normal form is kept per useful nonterminal A, made of
+// the live productions of every nonterminal A reaches through unit productions, so an edit of B's
+// productions recomputes only the nonterminals that reach B that way. The automaton guesses a leftmost
+// derivation on its stack, one transition per production, so an edit replaces only the transitions of
+// the edited nonterminal.
+class GrammarEditor
+{
+public:
+	using Symbol = Grammar::Symbol;
+	using SymbolString = Grammar::SymbolString;
+	using SymbolStringView = Grammar::SymbolStringView;
+	using Production = Grammar::Production;
+
+public:
+	static const char kGeneratedNameMark = '\''; // A'1, A'2, ... chain A's long productions, 'a derives a
+
+public:
+	GrammarEditor(const Grammar& grammar); // context independent and without lambda productions
+
+public:
+	Symbol AddNonterminal(std::string_view name); // the new names compile the automaton again
+	Symbol AddTerminal(std::string_view name);
+	bool AddProduction(const Production& production); // false if the grammar already has it
+	bool RemoveProduction(const Production& production); // false if the grammar does not have it
+
+public:
+	const Grammar& GetGrammar() const;
+	bool IsProductive(Symbol nonterminal) const;
+	bool IsReachable(Symbol nonterminal) const;
+	bool IsUseful(Symbol nonterminal) const;
+	Grammar GetChomskyGrammar() const; // the kept productions of every useful nonterminal, copied into one grammar
+	const PushDownAutomaton& GetAutomaton() const; // accepts by empty stack
+	size_t GetRecomputedCount() const; // nonterminals whose normal form the last edit recomputed
+
+private:
+	void mf_CheckName(std::string_view name) const;
+	size_t mf_FindProduction(const Production& production) const;
+	void mf_Update(Symbol left, const std::vector<Symbol>& lostTargets); // after the productions of left changed and productivity was updated
+
+private:
+	void mf_SetProductive(Symbol symbol, bool productive);
+	void mf_MarkProductive(Symbol symbol);
+	void mf_RecheckProductive(Symbol symbol);
+	void mf_SetReachable(Symbol symbol, bool reachable);
+	void mf_MarkReachable(Symbol symbol);
+	void mf_RecheckReachable(const std::vector<Symbol>& symbols);
+	void mf_TouchSymbol(Symbol symbol);
+	void mf_TouchProduction(size_t productionIndex);
+	void mf_ClearTouched();
+	void mf_ResizeSymbolTables(); // after names are interned
+
+private:
+	void mf_RecomputeChomskyProductions(Symbol nonterminal);
+	Symbol mf_GetWrapper(Symbol terminal);
+	std::unordered_map<std::string, PushDownAutomaton::DeltaResult> mf_GetTransitions(Symbol nonterminal) const;
+	void mf_BuildAutomaton();
+
+private:
+	Grammar m_grammar;
+	std::vector<uint32_t> m_unproductiveCounts; // per production, occurrences of nonproductive nonterminals in its right part
+	std::vector<uint8_t> m_isLive; // per production, as last seen by reachability
+	std::vector<uint8_t> m_isProductive; // per symbol id
+	std::vector<uint8_t> m_isReachable;
+	std::vector<std::vector<Production>> m_chomskyProductions; // per nonterminal, its part of the normal form
+	std::vector<Symbol> m_wrappedTerminals; // per symbol id, the terminal a wrapper derives
+	PushDownAutomaton m_automaton;
+	bool m_separatePushedSymbols;
+	size_t m_recomputedCount;
+
+private:
+	// What one edit touched, with the usefulness of every symbol before it.
+	std::vector<std::pair<Symbol, bool>> m_touchedSymbols;
+	std::vector<uint8_t> m_isSymbolTouched;
+	std::vector<size_t> m_touchedProductions;
+	std::vector<uint8_t> m_isProductionTouched;
+	std::vector<uint8_t> m_isDirty;
+	std::vector<uint8_t> m_isInClosure;
+};
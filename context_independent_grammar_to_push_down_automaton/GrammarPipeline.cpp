@@ -0,0 +1,72 @@
+#include "GrammarPipeline.h"
+#include <utility>
+
+GrammarPipeline::GrammarPipeline(Grammar grammar)
+	: GrammarPipeline(std::make_shared<const Grammar>(std::move(grammar)))
+{
+	/* EMPTY */
+}
+
+GrammarPipeline::GrammarPipeline(Snapshot grammar)
+{
+	for (std::atomic<bool>& isComputed : m_isComputed) {
+		isComputed.store(false, std::memory_order_relaxed);
+	}
+	m_snapshots[static_cast<size_t>(Stage::Original)] = std::move(grammar);
+	m_isComputed[static_cast<size_t>(Stage::Original)].store(true, std::memory_order_release);
+}
+
+GrammarPipeline::Snapshot GrammarPipeline::Get(Stage stage) const
+{
+	const size_t index = static_cast<size_t>(stage);
+	if (!m_isComputed[index].load(std::memory_order_acquire)) {
+		// A pass that throws leaves the flag unset, so the next access tries again.
+		std::call_once(m_onceFlags[index], [this, stage, index]() {
+			m_snapshots[index] = mf_Compute(stage);
+			m_isComputed[index].store(true, std::memory_order_release);
+		});
+	}
+	return m_snapshots[index];
+}
+
+GrammarPipeline::Snapshot GrammarPipeline::GetOriginal() const
+{
+	return Get(Stage::Original);
+}
+
+GrammarPipeline::Snapshot GrammarPipeline::GetSimplified() const
+{
+	return Get(Stage::Simplified);
+}
+
+GrammarPipeline::Snapshot GrammarPipeline::GetChomsky() const
+{
+	return Get(Stage::Chomsky);
+}
+
+GrammarPipeline::Snapshot GrammarPipeline::GetGreibach() const
+{
+	return Get(Stage::Greibach);
+}
+
+bool GrammarPipeline::IsComputed(Stage stage) const
+{
+	return m_isComputed[static_cast<size_t>(stage)].load(std::memory_order_acquire);
+}
+
+GrammarPipeline::Snapshot GrammarPipeline::mf_Compute(Stage stage) const
+{
+	const Snapshot input = Get(static_cast<Stage>(static_cast<size_t>(stage) - 1));
+	auto output = std::make_shared<Grammar>(*input);
+	switch (stage)
+	{
+	case Stage::Simplified: output->SimplifyGrammar(); break;
+	case Stage::Chomsky: output->MakeItChomsky(); break;
+	case Stage::Greibach: output->MakeItGreibach(); break;
+	default: break;
+	}
+	if (*output == *input) {
+		return input;
+	}
+	return output;
+}
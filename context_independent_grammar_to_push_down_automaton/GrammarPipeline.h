@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "Grammar.h"
+
+// The normal forms of one grammar as immutable snapshots: the original, the simplified grammar, its
+// Chomsky form and the Greibach form of that. Nothing is transformed in place; a stage is computed from
+// the stage before it on first access, once even when several threads ask for it, and never changes
+// afterwards. A stage that changes nothing is the snapshot of the stage before it, and the stages share
+// their symbol table until a pass adds a name.
+class GrammarPipeline
+{
+public:
+	enum class Stage : uint8_t
+	{
+		Original,
+		Simplified,
+		Chomsky,
+		Greibach
+	};
+
+public:
+	using Snapshot = std::shared_ptr<const Grammar>;
+
+public:
+	GrammarPipeline(Grammar grammar);
+	GrammarPipeline(Snapshot grammar);
+	GrammarPipeline(const GrammarPipeline& grammarPipeline) = delete;
+
+public:
+	GrammarPipeline& operator =(const GrammarPipeline& grammarPipeline) = delete;
+
+public:
+	Snapshot Get(Stage stage) const;
+	Snapshot GetOriginal() const;
+	Snapshot GetSimplified() const;
+	Snapshot GetChomsky() const;
+	Snapshot GetGreibach() const;
+	bool IsComputed(Stage stage) const;
+
+private:
+	static constexpr size_t kStagesCount = 4;
+
+private:
+	Snapshot mf_Compute(Stage stage) const; // from the stage before it
+
+private:
+	mutable std::array<Snapshot, kStagesCount> m_snapshots;
+	mutable std::array<std::once_flag, kStagesCount> m_onceFlags;
+	mutable std::array<std::atomic<bool>, kStagesCount> m_isComputed;
+};
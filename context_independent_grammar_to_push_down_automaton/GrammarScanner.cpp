@@ -0,0 +1,115 @@
+#include "GrammarScanner.h"
+#include <limits>
+
+GrammarScanner::GrammarScanner(std::string_view text)
+	: m_text(text)
+	, m_position(0)
+	, m_line(1)
+	, m_lineBegin(0)
+{
+	/* EMPTY */
+}
+
+bool GrammarScanner::AtEnd()
+{
+	mf_SkipWhitespace();
+	return m_position == m_text.size();
+}
+
+char GrammarScanner::Peek()
+{
+	return AtEnd() ? '\0' : m_text[m_position];
+}
+
+size_t GrammarScanner::GetLine() const
+{
+	return m_line;
+}
+
+size_t GrammarScanner::GetColumn() const
+{
+	return m_position - m_lineBegin + 1;
+}
+
+uint64_t GrammarScanner::ReadCount()
+{
+	if (AtEnd() || m_text[m_position] < '0' || m_text[m_position] > '9') {
+		Fail("A count was expected.");
+	}
+	uint64_t count = 0;
+	for (; m_position < m_text.size() && m_text[m_position] >= '0' && m_text[m_position] <= '9'; ++m_position) {
+		const uint64_t digit = static_cast<uint64_t>(m_text[m_position] - '0');
+		if (count > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+			Fail("The count is too large.");
+		}
+		count = count * 10 + digit;
+	}
+	return count;
+}
+
+char GrammarScanner::ReadCharacter()
+{
+	if (AtEnd()) {
+		Fail("A symbol was expected.");
+	}
+	return m_text[m_position++];
+}
+
+std::string_view GrammarScanner::ReadToken()
+{
+	if (AtEnd()) {
+		Fail("A production part was expected.");
+	}
+	const size_t begin = m_position;
+	while (m_position < m_text.size() && !mf_IsWhitespace(m_text[m_position])) {
+		++m_position;
+	}
+	return m_text.substr(begin, m_position - begin);
+}
+
+std::string_view GrammarScanner::ReadDelimited(char open, char close)
+{
+	if (Peek() != open) {
+		Fail("A symbol was expected.");
+	}
+	const size_t begin = ++m_position;
+	while (m_position < m_text.size() && m_text[m_position] != close) {
+		if (mf_IsWhitespace(m_text[m_position])) {
+			Fail("A symbol name cannot contain white space.");
+		}
+		++m_position;
+	}
+	if (m_position == m_text.size()) {
+		Fail("The symbol name is not closed.");
+	}
+	return m_text.substr(begin, m_position++ - begin);
+}
+
+bool GrammarScanner::Accept(std::string_view expected)
+{
+	if (AtEnd() || m_text.substr(m_position, expected.size()) != expected) {
+		return false;
+	}
+	m_position += expected.size();
+	return true;
+}
+
+void GrammarScanner::Fail(const char* message) const
+{
+	throw Error{ m_line, GetColumn(), message };
+}
+
+void GrammarScanner::mf_SkipWhitespace()
+{
+	for (; m_position < m_text.size() && mf_IsWhitespace(m_text[m_position]); ++m_position) {
+		if (m_text[m_position] == '\n') {
+			++m_line;
+			m_lineBegin = m_position + 1;
+		}
+	}
+}
+
+bool GrammarScanner::mf_IsWhitespace(char character)
+{
+	return character <= ' ' && (character == ' ' || character == '\t' || character == '\n' || character == '\r' || character == '\v' || character == '\f');
+}
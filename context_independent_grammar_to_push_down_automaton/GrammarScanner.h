@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Hand-written scanner over the text of a grammar file. Tokens are views into the text, nothing is copied,
+// and the line and column of the current position are kept so every error can point at its place.
+class GrammarScanner
+{
+public:
+	struct Error
+	{
+		size_t line; // both 1-based
+		size_t column;
+		const char* message;
+	};
+
+public:
+	GrammarScanner(std::string_view text);
+
+public:
+	bool AtEnd(); // after skipping white space
+	char Peek(); // the next character that is not white space, '\0' at the end
+	size_t GetLine() const;
+	size_t GetColumn() const;
+
+public:
+	uint64_t ReadCount(); // a non-negative decimal number
+	char ReadCharacter(); // the next character that is not white space
+	std::string_view ReadToken(); // the next run of characters that are not white space
+	std::string_view ReadDelimited(char open, char close); // the text between open and close, on one line and without white space
+	bool Accept(std::string_view expected); // consumes expected if the text continues with it
+
+public:
+	[[noreturn]] void Fail(const char* message) const;
+
+private:
+	void mf_SkipWhitespace();
+	static bool mf_IsWhitespace(char character);
+
+private:
+	std::string_view m_text;
+	size_t m_position;
+	size_t m_line;
+	size_t m_lineBegin;
+};
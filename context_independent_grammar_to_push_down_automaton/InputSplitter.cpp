@@ -0,0 +1,49 @@
+#include "InputSplitter.h"
+#include <numeric>
+
+InputSplitter::InputSplitter(const Grammar& grammar)
+	: m_hasLongNames(false)
+{
+	const SymbolTable& symbolTable = grammar.GetSymbolTable();
+	const std::vector<Grammar::Symbol>& terminals = grammar.GetTerminalSymbols();
+	std::vector<size_t> order(terminals.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&symbolTable, &terminals](size_t first, size_t second) {
+		return symbolTable.GetName(terminals[first]) < symbolTable.GetName(terminals[second]);
+	});
+	m_characterSymbols.fill(SymbolTable::kNoSymbol);
+	for (size_t i : order) {
+		const std::string& name = symbolTable.GetName(terminals[i]);
+		if (name.empty()) {
+			continue;
+		}
+		m_names.push_back(name);
+		m_symbols.push_back(terminals[i]);
+		if (name.size() == 1) {
+			m_characterSymbols[static_cast<unsigned char>(name[0])] = terminals[i];
+		}
+		else {
+			m_hasLongNames = true;
+		}
+	}
+}
+
+void InputSplitter::Split(std::string_view word, std::vector<uint32_t>& offsets, std::vector<Match>& matches) const
+{
+	offsets.clear();
+	matches.clear();
+	for (size_t position = 0; position < word.size(); ++position) {
+		offsets.push_back(static_cast<uint32_t>(matches.size()));
+		if (!m_hasLongNames) {
+			const Grammar::Symbol symbol = m_characterSymbols[static_cast<unsigned char>(word[position])];
+			if (symbol != SymbolTable::kNoSymbol) {
+				matches.push_back({ symbol, 1 });
+			}
+			continue;
+		}
+		ForEachNameAt(m_names.begin(), m_names.end(), word, position, [this, &matches](auto name, size_t length) {
+			matches.push_back({ m_symbols[name - m_names.begin()], static_cast<uint32_t>(length) });
+		});
+	}
+	offsets.push_back(static_cast<uint32_t>(matches.size()));
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Grammar.h"
+
+// Every way a word is split over the terminal names of a grammar, some of which may be longer than one
+// character. Words are read by characters: at each position, the matches are the terminals whose names
+// the rest of the word starts with, so a parser that moves past a match by its length follows all the
+// splits at once.
+class InputSplitter
+{
+public:
+	struct Match
+	{
+		Grammar::Symbol symbol;
+		uint32_t length; // in characters
+	};
+
+public:
+	InputSplitter(const Grammar& grammar);
+
+public:
+	// The matches at position i are matches[offsets[i], offsets[i + 1]), shortest first.
+	void Split(std::string_view word, std::vector<uint32_t>& offsets, std::vector<Match>& matches) const;
+
+public:
+	// Calls visit(name, length) for every name of the sorted range [begin, end) that the word starts with
+	// at position, shortest first.
+	template <typename Iterator, typename Visit>
+	static void ForEachNameAt(Iterator begin, Iterator end, std::string_view word, size_t position, Visit visit);
+
+private:
+	std::vector<std::string> m_names; // sorted
+	std::vector<Grammar::Symbol> m_symbols; // of m_names
+	std::array<Grammar::Symbol, 256> m_characterSymbols; // used instead of m_names when no name is longer
+	bool m_hasLongNames;
+};
+
+template <typename Iterator, typename Visit>
+void InputSplitter::ForEachNameAt(Iterator begin, Iterator end, std::string_view word, size_t position, Visit visit)
+{
+	// The names that start with the characters read so far are a range of the sorted names, narrowed one
+	// character at a time; a name equal to those characters is the first of its range.
+	for (size_t length = 0; position + length < word.size() && begin != end; ++length) {
+		const unsigned char character = static_cast<unsigned char>(word[position + length]);
+		begin = std::lower_bound(begin, end, character, [length](const std::string& name, unsigned char value) {
+			return name.size() <= length || static_cast<unsigned char>(name[length]) < value;
+		});
+		end = std::upper_bound(begin, end, character, [length](unsigned char value, const std::string& name) {
+			return value < static_cast<unsigned char>(name[length]);
+		});
+		if (begin != end && begin->size() == length + 1) {
+			visit(begin, length + 1);
+		}
+	}
+}
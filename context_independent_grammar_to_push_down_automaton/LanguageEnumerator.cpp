@@ -0,0 +1,279 @@
+#include "LanguageEnumerator.h"
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <utility>
+
+LanguageEnumerator::LanguageEnumerator(const Grammar& chomskyGrammar, size_t maxLength, size_t memoryLimit)
+	: m_nonterminalsCount(chomskyGrammar.GetNonterminalSymbols().size())
+	, m_acceptsEmptyWord(false)
+	, m_maxLength(maxLength)
+	, m_memoryLimit(memoryLimit)
+	, m_nextLength(0)
+	, m_sortedPosition(0)
+	, m_hasLastWord(false)
+	, m_spilledRunsCount(0)
+{
+	const SymbolTable& symbolTable = chomskyGrammar.GetSymbolTable();
+	const auto& nonterminals = chomskyGrammar.GetNonterminalSymbols();
+	m_nonterminalIndexes.assign(symbolTable.Size(), kNoSymbol);
+	for (size_t i = 0; i < nonterminals.size(); ++i) {
+		m_nonterminalIndexes[nonterminals[i]] = static_cast<uint32_t>(i);
+	}
+	std::vector<bool> isTerminal(symbolTable.Size(), false);
+	for (Grammar::Symbol symbol : chomskyGrammar.GetTerminalSymbols()) {
+		isTerminal[symbol] = true;
+	}
+	m_startIndex = mf_GetNonterminalIndex(chomskyGrammar.GetStartSymbol());
+	m_terminalRules.resize(m_nonterminalsCount);
+	m_binaryRules.resize(m_nonterminalsCount);
+
+	for (const auto& [left, right] : chomskyGrammar.GetProductions()) {
+		const uint32_t leftIndex = left.size() == 1 ? mf_GetNonterminalIndex(left[0]) : kNoSymbol;
+		if (leftIndex == kNoSymbol) {
+			throw "The grammar is not in Chomsky normal form.";
+		}
+		if (right.size() == 1 && right[0] == Grammar::kLambdaSymbol) {
+			if (leftIndex != m_startIndex) {
+				throw "The grammar is not in Chomsky normal form.";
+			}
+			m_acceptsEmptyWord = true;
+			continue;
+		}
+		if (right.size() == 1 && isTerminal[right[0]]) {
+			m_terminalRules[leftIndex].push_back(symbolTable.GetName(right[0]));
+			continue;
+		}
+		const uint32_t firstIndex = right.size() == 2 ? mf_GetNonterminalIndex(right[0]) : kNoSymbol;
+		const uint32_t secondIndex = right.size() == 2 ? mf_GetNonterminalIndex(right[1]) : kNoSymbol;
+		if (firstIndex == kNoSymbol || secondIndex == kNoSymbol) {
+			throw "The grammar is not in Chomsky normal form.";
+		}
+		m_binaryRules[leftIndex].push_back({ firstIndex, secondIndex });
+	}
+	for (auto& terminals : m_terminalRules) {
+		std::sort(terminals.begin(), terminals.end());
+	}
+
+	// A derives a word of length n when it has a rule A ---> a (n = 1) or a rule A ---> BC and a split
+	// 0 < k < n with B deriving length k and C length n - k.
+	m_derives.assign((m_maxLength + 1) * m_nonterminalsCount, false);
+	for (size_t length = 1; length <= m_maxLength; ++length) {
+		for (uint32_t nonterminal = 0; nonterminal < m_nonterminalsCount; ++nonterminal) {
+			bool derives = length == 1 && !m_terminalRules[nonterminal].empty();
+			for (const BinaryRule& rule : m_binaryRules[nonterminal]) {
+				for (size_t split = 1; split < length && !derives; ++split) {
+					derives = mf_Derives(rule.first, split) && mf_Derives(rule.second, length - split);
+				}
+			}
+			m_derives[length * m_nonterminalsCount + nonterminal] = derives;
+		}
+	}
+	mf_ClearSet();
+}
+LanguageEnumerator::~LanguageEnumerator()
+{
+	mf_CloseRuns();
+}
+
+bool LanguageEnumerator::Next(std::string& word)
+{
+	while (true) {
+		if (!m_runs.empty()) {
+			Run* smallest = nullptr;
+			for (Run& run : m_runs) {
+				if (!run.exhausted && (!smallest || run.current < smallest->current)) {
+					smallest = &run;
+				}
+			}
+			if (!smallest) {
+				mf_CloseRuns();
+				continue;
+			}
+			word = smallest->current;
+			smallest->exhausted = !mf_ReadWord(*smallest);
+			// Every run is free of duplicates, but the same word may be in several of them.
+			if (m_hasLastWord && word == m_lastWord) {
+				continue;
+			}
+			m_lastWord = word;
+			m_hasLastWord = true;
+			return true;
+		}
+		if (m_sortedPosition < m_sortedWords.size()) {
+			const uint32_t index = m_sortedWords[m_sortedPosition++];
+			word.assign(m_characters, m_wordOffsets[index], m_wordOffsets[index + 1] - m_wordOffsets[index]);
+			return true;
+		}
+		if (m_nextLength > m_maxLength || m_startIndex == kNoSymbol) {
+			return false;
+		}
+		mf_PrepareLength(m_nextLength++);
+	}
+}
+
+size_t LanguageEnumerator::GetSpilledRunsCount() const
+{
+	return m_spilledRunsCount;
+}
+
+uint32_t LanguageEnumerator::mf_GetNonterminalIndex(Grammar::Symbol symbol) const
+{
+	return symbol < m_nonterminalIndexes.size() ? m_nonterminalIndexes[symbol] : kNoSymbol;
+}
+
+bool LanguageEnumerator::mf_Derives(uint32_t nonterminal, size_t length) const
+{
+	return m_derives[length * m_nonterminalsCount + nonterminal];
+}
+
+void LanguageEnumerator::mf_PrepareLength(size_t length)
+{
+	mf_ClearSet();
+	m_sortedWords.clear();
+	m_sortedPosition = 0;
+	m_hasLastWord = false;
+
+	if (length == 0) {
+		if (m_acceptsEmptyWord) {
+			mf_Insert({});
+		}
+	}
+	else if (mf_Derives(m_startIndex, length)) {
+		std::vector<std::pair<uint32_t, size_t>> goals{ { m_startIndex, length } };
+		std::string buffer;
+		mf_Enumerate(goals, buffer);
+	}
+
+	if (m_runs.empty()) {
+		m_sortedWords = mf_SortedWords();
+		return;
+	}
+	mf_SpillRun();
+	for (Run& run : m_runs) {
+		std::rewind(run.file);
+		run.exhausted = !mf_ReadWord(run);
+	}
+}
+
+void LanguageEnumerator::mf_Enumerate(std::vector<std::pair<uint32_t, size_t>>& goals, std::string& buffer)
+{
+	// The goals still to be derived, the leftmost on top; buffer holds the terminals derived so far.
+	if (goals.empty()) {
+		mf_Insert(buffer);
+		return;
+	}
+	const auto [nonterminal, length] = goals.back();
+	goals.pop_back();
+	if (length == 1) {
+		for (const std::string& terminal : m_terminalRules[nonterminal]) {
+			const size_t size = buffer.size();
+			buffer += terminal;
+			mf_Enumerate(goals, buffer);
+			buffer.resize(size);
+		}
+	}
+	else {
+		for (const BinaryRule& rule : m_binaryRules[nonterminal]) {
+			for (size_t split = 1; split < length; ++split) {
+				if (!mf_Derives(rule.first, split) || !mf_Derives(rule.second, length - split)) {
+					continue;
+				}
+				goals.emplace_back(rule.second, length - split);
+				goals.emplace_back(rule.first, split);
+				mf_Enumerate(goals, buffer);
+				goals.resize(goals.size() - 2);
+			}
+		}
+	}
+	goals.emplace_back(nonterminal, length);
+}
+
+void LanguageEnumerator::mf_Insert(std::string_view word)
+{
+	const auto getWord = [this](uint32_t index) {
+		return std::string_view(m_characters).substr(m_wordOffsets[index], m_wordOffsets[index + 1] - m_wordOffsets[index]);
+	};
+	size_t mask = m_buckets.size() - 1;
+	size_t bucket = std::hash<std::string_view>()(word) & mask;
+	for (; m_buckets[bucket]; bucket = (bucket + 1) & mask) {
+		if (getWord(m_buckets[bucket] - 1) == word) {
+			return;
+		}
+	}
+	m_characters += word;
+	m_wordOffsets.push_back(m_characters.size());
+	const size_t wordsCount = m_wordOffsets.size() - 1;
+	m_buckets[bucket] = static_cast<uint32_t>(wordsCount);
+
+	// Linear probing, kept at most half full.
+	if (wordsCount * 2 > m_buckets.size()) {
+		m_buckets.assign(m_buckets.size() * 2, 0);
+		mask = m_buckets.size() - 1;
+		for (uint32_t index = 0; index < wordsCount; ++index) {
+			for (bucket = std::hash<std::string_view>()(getWord(index)) & mask; m_buckets[bucket]; bucket = (bucket + 1) & mask);
+			m_buckets[bucket] = index + 1;
+		}
+	}
+
+	const size_t memory = m_characters.size() + m_wordOffsets.size() * sizeof(size_t) + m_buckets.size() * sizeof(uint32_t);
+	if (memory > m_memoryLimit) {
+		mf_SpillRun();
+	}
+}
+
+void LanguageEnumerator::mf_SpillRun()
+{
+	std::FILE* file = std::tmpfile();
+	if (!file) {
+		throw "The words could not be spilled to a temporary file.";
+	}
+	m_runs.push_back({ file, {}, false });
+	for (uint32_t index : mf_SortedWords()) {
+		std::fwrite(m_characters.data() + m_wordOffsets[index], 1, m_wordOffsets[index + 1] - m_wordOffsets[index], file);
+		std::fputc('\n', file);
+	}
+	if (std::ferror(file)) {
+		throw "The words could not be spilled to a temporary file.";
+	}
+	++m_spilledRunsCount;
+	mf_ClearSet();
+}
+
+std::vector<uint32_t> LanguageEnumerator::mf_SortedWords() const
+{
+	std::vector<uint32_t> indexes(m_wordOffsets.size() - 1);
+	std::iota(indexes.begin(), indexes.end(), 0);
+	const std::string_view characters(m_characters);
+	std::sort(indexes.begin(), indexes.end(), [&](uint32_t left, uint32_t right) {
+		return characters.substr(m_wordOffsets[left], m_wordOffsets[left + 1] - m_wordOffsets[left])
+			< characters.substr(m_wordOffsets[right], m_wordOffsets[right + 1] - m_wordOffsets[right]);
+	});
+	return indexes;
+}
+
+void LanguageEnumerator::mf_ClearSet()
+{
+	m_characters.clear();
+	m_wordOffsets.assign(1, 0);
+	m_buckets.assign(16, 0);
+}
+
+void LanguageEnumerator::mf_CloseRuns()
+{
+	for (Run& run : m_runs) {
+		std::fclose(run.file);
+	}
+	m_runs.clear();
+}
+
+bool LanguageEnumerator::mf_ReadWord(Run& run)
+{
+	// One word per line; terminal names never contain white space.
+	run.current.clear();
+	int character;
+	while ((character = std::getc(run.file)) != EOF && character != '\n') {
+		run.current += static_cast<char>(character);
+	}
+	return character != EOF;
+}
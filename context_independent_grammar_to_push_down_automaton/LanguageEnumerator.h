@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Grammar.h"
+
+// Lists the distinct words of a grammar in Chomsky normal form in shortlex order (by length, then
+// lexicographically), up to a length limit, one word per Next() call. The words of one length are found by
+// a depth-first walk over (nonterminal, length) goals that only visits goals deriving some word, and are
+// deduplicated in a hash set kept in one character buffer. When the set outgrows the memory limit it is
+// sorted and spilled to a temporary file; the sorted runs of a length are then merged while streaming.
+class LanguageEnumerator
+{
+public:
+	LanguageEnumerator(const Grammar& chomskyGrammar, size_t maxLength, size_t memoryLimit = kDefaultMemoryLimit);
+	LanguageEnumerator(const LanguageEnumerator& languageEnumerator) = delete;
+	~LanguageEnumerator();
+
+public:
+	LanguageEnumerator& operator =(const LanguageEnumerator& languageEnumerator) = delete;
+
+public:
+	static constexpr size_t kDefaultMemoryLimit = Grammar::kEnumerationMemoryLimit;
+
+public:
+	bool Next(std::string& word); // false once every word up to the length limit has been listed
+	size_t GetSpilledRunsCount() const; // runs written to disk so far, for tuning the memory limit
+
+private:
+	struct BinaryRule
+	{
+		uint32_t first;
+		uint32_t second;
+	};
+
+	struct Run
+	{
+		std::FILE* file;
+		std::string current;
+		bool exhausted;
+	};
+
+private:
+	uint32_t mf_GetNonterminalIndex(Grammar::Symbol symbol) const;
+	bool mf_Derives(uint32_t nonterminal, size_t length) const;
+	void mf_PrepareLength(size_t length);
+	void mf_Enumerate(std::vector<std::pair<uint32_t, size_t>>& goals, std::string& buffer);
+	void mf_Insert(std::string_view word);
+	void mf_SpillRun();
+	std::vector<uint32_t> mf_SortedWords() const;
+	void mf_ClearSet();
+	void mf_CloseRuns();
+	static bool mf_ReadWord(Run& run);
+
+private:
+	static constexpr uint32_t kNoSymbol = UINT32_MAX;
+
+private:
+	std::vector<uint32_t> m_nonterminalIndexes; // per symbol id
+	size_t m_nonterminalsCount;
+	uint32_t m_startIndex;
+	bool m_acceptsEmptyWord;
+	size_t m_maxLength;
+	size_t m_memoryLimit;
+	std::vector<std::vector<std::string>> m_terminalRules; // per nonterminal, sorted
+	std::vector<std::vector<BinaryRule>> m_binaryRules;
+	std::vector<bool> m_derives; // length * m_nonterminalsCount + nonterminal
+
+private:
+	std::string m_characters; // the words of the set, back to back
+	std::vector<size_t> m_wordOffsets; // word i is [m_wordOffsets[i], m_wordOffsets[i + 1])
+	std::vector<uint32_t> m_buckets; // word index + 1, 0 for an empty bucket
+
+private:
+	size_t m_nextLength;
+	std::vector<uint32_t> m_sortedWords; // the current length when it fit in memory
+	size_t m_sortedPosition;
+	std::vector<Run> m_runs; // the current length when it was spilled
+	std::string m_lastWord;
+	bool m_hasLastWord;
+	size_t m_spilledRunsCount;
+};
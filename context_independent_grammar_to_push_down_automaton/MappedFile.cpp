@@ -0,0 +1,132 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& path)
+	: m_data(nullptr)
+	, m_size(0)
+	, m_file(INVALID_HANDLE_VALUE)
+	, m_mapping(nullptr)
+{
+	m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER size;
+	if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size)) {
+		mf_Unmap();
+		throw "The file could not be mapped.";
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+	if (!m_size) {
+		return;
+	}
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	m_data = m_mapping ? static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+	if (!m_data) {
+		mf_Unmap();
+		throw "The file could not be mapped.";
+	}
+}
+#else
+MappedFile::MappedFile(const std::string& path)
+	: m_data(nullptr)
+	, m_size(0)
+{
+	const int file = open(path.c_str(), O_RDONLY);
+	struct stat status;
+	if (file < 0 || fstat(file, &status) != 0) {
+		if (file >= 0) {
+			close(file);
+		}
+		throw "The file could not be mapped.";
+	}
+	m_size = static_cast<size_t>(status.st_size);
+	if (m_size) {
+		void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+		m_data = data != MAP_FAILED ? static_cast<const uint8_t*>(data) : nullptr;
+	}
+	// The mapping keeps the file alive on its own.
+	close(file);
+	if (m_size && !m_data) {
+		m_size = 0;
+		throw "The file could not be mapped.";
+	}
+}
+#endif
+
+MappedFile::MappedFile(MappedFile&& mappedFile) noexcept
+	: m_data(std::exchange(mappedFile.m_data, nullptr))
+	, m_size(std::exchange(mappedFile.m_size, 0))
+#ifdef _WIN32
+	, m_file(std::exchange(mappedFile.m_file, INVALID_HANDLE_VALUE))
+	, m_mapping(std::exchange(mappedFile.m_mapping, nullptr))
+#endif
+{
+	/* EMPTY */
+}
+
+MappedFile::~MappedFile()
+{
+	mf_Unmap();
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& mappedFile) noexcept
+{
+	if (this != &mappedFile) {
+		mf_Unmap();
+		m_data = std::exchange(mappedFile.m_data, nullptr);
+		m_size = std::exchange(mappedFile.m_size, 0);
+#ifdef _WIN32
+		m_file = std::exchange(mappedFile.m_file, INVALID_HANDLE_VALUE);
+		m_mapping = std::exchange(mappedFile.m_mapping, nullptr);
+#endif
+	}
+	return *this;
+}
+
+const uint8_t* MappedFile::GetData() const
+{
+	return m_data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return m_size;
+}
+
+std::span<const uint8_t> MappedFile::GetBytes() const
+{
+	return std::span<const uint8_t>(m_data, m_size);
+}
+
+void MappedFile::mf_Unmap()
+{
+#ifdef _WIN32
+	if (m_data) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping) {
+		CloseHandle(m_mapping);
+	}
+	if (m_file != INVALID_HANDLE_VALUE) {
+		CloseHandle(m_file);
+	}
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = nullptr;
+#else
+	if (m_data) {
+		munmap(const_cast<uint8_t*>(m_data), m_size);
+	}
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
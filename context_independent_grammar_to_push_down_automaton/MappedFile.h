@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+// Read-only memory mapping of a whole file, through mmap on POSIX systems and a file mapping on Windows.
+// The bytes stay valid as long as the object lives; it can be moved but not copied.
+class MappedFile
+{
+public:
+	MappedFile(const std::string& path);
+	MappedFile(const MappedFile& mappedFile) = delete;
+	MappedFile(MappedFile&& mappedFile) noexcept;
+	~MappedFile();
+
+public:
+	MappedFile& operator =(const MappedFile& mappedFile) = delete;
+	MappedFile& operator =(MappedFile&& mappedFile) noexcept;
+
+public:
+	const uint8_t* GetData() const;
+	size_t GetSize() const;
+	std::span<const uint8_t> GetBytes() const;
+
+private:
+	void mf_Unmap();
+
+private:
+	const uint8_t* m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#endif
+};
@@ -0,0 +1,144 @@
+#include "ParseForest.h"
+
+ParseForest::ParseForest()
+	: m_root(kNoNode)
+{
+	/* EMPTY */
+}
+
+bool ParseForest::Empty() const
+{
+	return m_root == kNoNode;
+}
+
+uint32_t ParseForest::GetRoot() const
+{
+	return m_root;
+}
+
+const ParseForest::Node& ParseForest::GetNode(uint32_t node) const
+{
+	return m_nodes[node];
+}
+
+const ParseForest::Family& ParseForest::GetFamily(uint32_t family) const
+{
+	return m_families[family];
+}
+
+size_t ParseForest::GetNodesCount() const
+{
+	return m_nodes.size();
+}
+
+size_t ParseForest::GetFamiliesCount() const
+{
+	return m_families.size();
+}
+
+CompactDerivationTree ParseForest::ToCompactDerivationTree(uint32_t node) const
+{
+	if (m_nodes[node].kind == NodeKind::Intermediate) {
+		throw "Only symbol and terminal nodes stand for a derivation tree.";
+	}
+	CompactDerivationTree result(m_nodes[node].symbol);
+	if (m_nodes[node].kind == NodeKind::Symbol) {
+		mf_BuildSubtree(result, result.GetRoot(), node, mf_ChooseFiniteFamilies());
+	}
+	return result;
+}
+
+DerivationTree ParseForest::ToDerivationTree(uint32_t node, const SymbolTable& symbolTable) const
+{
+	return ToCompactDerivationTree(node).ToDerivationTree(symbolTable);
+}
+
+void ParseForest::Clear()
+{
+	m_nodes.clear();
+	m_families.clear();
+	m_root = kNoNode;
+}
+
+uint32_t ParseForest::mf_AddNode(NodeKind kind, SymbolTable::Symbol symbol, uint32_t production, uint32_t dot, uint32_t leftExtent, uint32_t rightExtent)
+{
+	m_nodes.push_back({ kind, symbol, production, dot, leftExtent, rightExtent, kNoNode });
+	return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+void ParseForest::mf_AddFamily(uint32_t node, uint32_t left, uint32_t right)
+{
+	for (uint32_t family = m_nodes[node].firstFamily; family != kNoNode; family = m_families[family].next) {
+		if (m_families[family].left == left && m_families[family].right == right) {
+			return;
+		}
+	}
+	m_families.push_back({ left, right, m_nodes[node].firstFamily });
+	m_nodes[node].firstFamily = static_cast<uint32_t>(m_families.size() - 1);
+}
+
+std::vector<uint32_t> ParseForest::mf_ChooseFiniteFamilies() const
+{
+	// A node gets a family once all the children of that family have one, so following the chosen
+	// families always reaches the leaves even when the grammar has cycles such as A ---> A.
+	std::vector<uint32_t> chosenFamilies(m_nodes.size(), kNoNode);
+	std::vector<bool> finite(m_nodes.size(), false);
+	for (size_t i = 0; i < m_nodes.size(); ++i) {
+		finite[i] = m_nodes[i].kind == NodeKind::Terminal;
+	}
+
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (size_t i = 0; i < m_nodes.size(); ++i) {
+			if (finite[i]) {
+				continue;
+			}
+			for (uint32_t family = m_nodes[i].firstFamily; family != kNoNode; family = m_families[family].next) {
+				const Family& packed = m_families[family];
+				if ((packed.left == kNoNode || finite[packed.left]) && (packed.right == kNoNode || finite[packed.right])) {
+					finite[i] = true;
+					chosenFamilies[i] = family;
+					changed = true;
+					break;
+				}
+			}
+		}
+	}
+	return chosenFamilies;
+}
+
+void ParseForest::mf_AppendChildren(uint32_t family, const std::vector<uint32_t>& chosenFamilies, std::vector<uint32_t>& children) const
+{
+	const Family& packed = m_families[family];
+	if (packed.left != kNoNode) {
+		if (m_nodes[packed.left].kind == NodeKind::Intermediate) {
+			mf_AppendChildren(chosenFamilies[packed.left], chosenFamilies, children);
+		}
+		else {
+			children.push_back(packed.left);
+		}
+	}
+	if (packed.right != kNoNode) {
+		children.push_back(packed.right);
+	}
+}
+
+void ParseForest::mf_BuildSubtree(CompactDerivationTree& tree, uint32_t treeNode, uint32_t node, const std::vector<uint32_t>& chosenFamilies) const
+{
+	if (chosenFamilies[node] == kNoNode) {
+		throw "The forest has no finite derivation for this node.";
+	}
+	std::vector<uint32_t> children;
+	mf_AppendChildren(chosenFamilies[node], chosenFamilies, children);
+	if (children.empty()) {
+		tree.AddChild(treeNode, kLambdaSymbol);
+		return;
+	}
+	for (uint32_t child : children) {
+		const uint32_t childTreeNode = tree.AddChild(treeNode, m_nodes[child].symbol);
+		if (m_nodes[child].kind == NodeKind::Symbol) {
+			mf_BuildSubtree(tree, childTreeNode, child, chosenFamilies);
+		}
+	}
+}
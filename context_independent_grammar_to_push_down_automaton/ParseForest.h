@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "CompactDerivationTree.h"
+#include "DerivationTree.h"
+#include "SymbolTable.h"
+
+// Shared packed parse forest. Nodes and packed nodes (families) live in two contiguous pools and refer to
+// each other by index, so all the derivations of a word share their common parts and the forest stays
+// within O(n^3) nodes however ambiguous the grammar is. A symbol node (A, i, j) says that A derives the
+// subword [i, j); each of its families is one way of doing it. Productions are binarised through
+// intermediate nodes: a family has the node of the last symbol on its right and the node of the prefix
+// before it (or nothing) on its left.
+class ParseForest
+{
+public:
+	enum class NodeKind : uint8_t
+	{
+		Symbol,
+		Intermediate,
+		Terminal
+	};
+
+public:
+	static constexpr SymbolTable::Symbol kLambdaSymbol = 0; // the id every grammar gives lambda
+	static constexpr uint32_t kNoNode = UINT32_MAX;
+
+public:
+	struct Node
+	{
+		NodeKind kind;
+		SymbolTable::Symbol symbol;
+		uint32_t production; // production index and dot of an intermediate node
+		uint32_t dot;
+		uint32_t leftExtent;
+		uint32_t rightExtent;
+		uint32_t firstFamily;
+	};
+
+	struct Family
+	{
+		uint32_t left;
+		uint32_t right; // both kNoNode for the empty derivation
+		uint32_t next;
+	};
+
+public:
+	ParseForest();
+
+public:
+	bool Empty() const;
+	uint32_t GetRoot() const;
+	const Node& GetNode(uint32_t node) const;
+	const Family& GetFamily(uint32_t family) const;
+	size_t GetNodesCount() const;
+	size_t GetFamiliesCount() const;
+
+public:
+	CompactDerivationTree ToCompactDerivationTree(uint32_t node) const; // one finite derivation of a symbol or terminal node
+	DerivationTree ToDerivationTree(uint32_t node, const SymbolTable& symbolTable) const;
+
+public:
+	void Clear(); // keeps the pools allocated for the next parse
+
+private:
+	friend class EarleyParser;
+
+private:
+	uint32_t mf_AddNode(NodeKind kind, SymbolTable::Symbol symbol, uint32_t production, uint32_t dot, uint32_t leftExtent, uint32_t rightExtent);
+	void mf_AddFamily(uint32_t node, uint32_t left, uint32_t right);
+
+private:
+	std::vector<uint32_t> mf_ChooseFiniteFamilies() const;
+	void mf_AppendChildren(uint32_t family, const std::vector<uint32_t>& chosenFamilies, std::vector<uint32_t>& children) const;
+	void mf_BuildSubtree(CompactDerivationTree& tree, uint32_t treeNode, uint32_t node, const std::vector<uint32_t>& chosenFamilies) const;
+
+private:
+	std::vector<Node> m_nodes;
+	std::vector<Family> m_families;
+	uint32_t m_root;
+};
@@ -0,0 +1,184 @@
+#include "PersistentDerivationTree.h"
+#include <utility>
+
+PersistentDerivationTree::PersistentDerivationTree()
+	: m_root(kNoNode)
+{
+	/* EMPTY */
+}
+
+PersistentDerivationTree::PersistentDerivationTree(Symbol startSymbol)
+	: m_arena(std::make_shared<Arena>())
+	, m_root(0)
+{
+	m_arena->nodes.push_back({ startSymbol, 0, 0, 1 });
+}
+
+PersistentDerivationTree::PersistentDerivationTree(std::shared_ptr<Arena> arena, uint32_t root)
+	: m_arena(std::move(arena))
+	, m_root(root)
+{
+	/* EMPTY */
+}
+
+bool PersistentDerivationTree::operator==(const PersistentDerivationTree& derivationTree) const
+{
+	if (Empty() || derivationTree.Empty()) {
+		return Empty() == derivationTree.Empty();
+	}
+	std::vector<std::pair<uint32_t, uint32_t>> pending{ { m_root, derivationTree.m_root } };
+	while (!pending.empty()) {
+		const auto [thisNode, thatNode] = pending.back();
+		pending.pop_back();
+		// Subtrees shared by both versions need no walk.
+		if (m_arena == derivationTree.m_arena && thisNode == thatNode) {
+			continue;
+		}
+		const Node& thisPart = GetNode(thisNode);
+		const Node& thatPart = derivationTree.GetNode(thatNode);
+		if (thisPart.symbol != thatPart.symbol || thisPart.childrenCount != thatPart.childrenCount) {
+			return false;
+		}
+		for (uint32_t i = 0; i < thisPart.childrenCount; ++i) {
+			pending.emplace_back(GetChild(thisNode, i), derivationTree.GetChild(thatNode, i));
+		}
+	}
+	return true;
+}
+
+PersistentDerivationTree PersistentDerivationTree::Expand(size_t leaf, const SymbolString& right) const
+{
+	if (leaf >= GetLeavesCount()) {
+		throw "The tree has no leaf at this position.";
+	}
+
+	// The path from the root to the leaf, as (node, position of the next node among its children).
+	std::vector<std::pair<uint32_t, uint32_t>> path;
+	uint32_t node = m_root;
+	while (GetNode(node).childrenCount) {
+		uint32_t position = 0;
+		for (uint32_t child = GetChild(node, position); leaf >= GetNode(child).leavesCount; child = GetChild(node, ++position)) {
+			leaf -= GetNode(child).leavesCount;
+		}
+		path.emplace_back(node, position);
+		node = GetChild(node, position);
+	}
+
+	// The expanded leaf gets its new children, then every node on the path is copied bottom up with the
+	// copy below it in place of the old child.
+	const SymbolString& symbols = right.empty() ? SymbolString(1, kLambdaSymbol) : right;
+	const uint32_t firstChild = static_cast<uint32_t>(m_arena->children.size());
+	for (Symbol symbol : symbols) {
+		m_arena->children.push_back(mf_AddNode(symbol, 0, 0, 1));
+	}
+	uint32_t copy = mf_AddNode(GetNode(node).symbol, firstChild, static_cast<uint32_t>(symbols.size()), static_cast<uint32_t>(symbols.size()));
+	const uint32_t addedLeaves = static_cast<uint32_t>(symbols.size()) - 1;
+	for (auto it = path.rbegin(); it != path.rend(); ++it) {
+		const auto [ancestor, position] = *it;
+		const Node original = GetNode(ancestor);
+		const uint32_t copiedChildren = static_cast<uint32_t>(m_arena->children.size());
+		for (uint32_t i = 0; i < original.childrenCount; ++i) {
+			m_arena->children.push_back(i == position ? copy : m_arena->children[original.firstChild + i]);
+		}
+		copy = mf_AddNode(original.symbol, copiedChildren, original.childrenCount, original.leavesCount + addedLeaves);
+	}
+	return PersistentDerivationTree(m_arena, copy);
+}
+
+uint32_t PersistentDerivationTree::GetRoot() const
+{
+	return m_root;
+}
+
+const PersistentDerivationTree::Node& PersistentDerivationTree::GetNode(uint32_t node) const
+{
+	return m_arena->nodes[node];
+}
+
+uint32_t PersistentDerivationTree::GetChild(uint32_t node, size_t index) const
+{
+	return m_arena->children[m_arena->nodes[node].firstChild + index];
+}
+
+size_t PersistentDerivationTree::GetLeavesCount() const
+{
+	return Empty() ? 0 : GetNode(m_root).leavesCount;
+}
+
+PersistentDerivationTree::Symbol PersistentDerivationTree::GetLeaf(size_t leaf) const
+{
+	if (leaf >= GetLeavesCount()) {
+		throw "The tree has no leaf at this position.";
+	}
+	uint32_t node = m_root;
+	while (GetNode(node).childrenCount) {
+		uint32_t position = 0;
+		for (uint32_t child = GetChild(node, position); leaf >= GetNode(child).leavesCount; child = GetChild(node, ++position)) {
+			leaf -= GetNode(child).leavesCount;
+		}
+		node = GetChild(node, position);
+	}
+	return GetNode(node).symbol;
+}
+
+PersistentDerivationTree::SymbolString PersistentDerivationTree::GetResult() const
+{
+	SymbolString result;
+	if (Empty()) {
+		return result;
+	}
+	result.reserve(GetLeavesCount());
+	std::vector<uint32_t> pending{ m_root };
+	while (!pending.empty()) {
+		const uint32_t node = pending.back();
+		pending.pop_back();
+		const Node& part = GetNode(node);
+		if (!part.childrenCount) {
+			result += part.symbol;
+			continue;
+		}
+		for (uint32_t i = part.childrenCount; i > 0; --i) {
+			pending.push_back(GetChild(node, i - 1));
+		}
+	}
+	return result;
+}
+
+std::string PersistentDerivationTree::GetResult(const SymbolTable& symbolTable) const
+{
+	return symbolTable.ToString(GetResult());
+}
+
+size_t PersistentDerivationTree::GetArenaSize() const
+{
+	return m_arena ? m_arena->nodes.size() : 0;
+}
+
+bool PersistentDerivationTree::Empty() const
+{
+	return m_root == kNoNode;
+}
+
+CompactDerivationTree PersistentDerivationTree::ToCompactDerivationTree() const
+{
+	if (Empty()) {
+		return CompactDerivationTree();
+	}
+	CompactDerivationTree result(GetNode(m_root).symbol);
+	std::vector<std::pair<uint32_t, uint32_t>> pending{ { m_root, result.GetRoot() } };
+	while (!pending.empty()) {
+		const auto [node, copy] = pending.back();
+		pending.pop_back();
+		for (uint32_t i = 0; i < GetNode(node).childrenCount; ++i) {
+			const uint32_t child = GetChild(node, i);
+			pending.emplace_back(child, result.AddChild(copy, GetNode(child).symbol));
+		}
+	}
+	return result;
+}
+
+uint32_t PersistentDerivationTree::mf_AddNode(Symbol symbol, uint32_t firstChild, uint32_t childrenCount, uint32_t leavesCount) const
+{
+	m_arena->nodes.push_back({ symbol, firstChild, childrenCount, leavesCount });
+	return static_cast<uint32_t>(m_arena->nodes.size() - 1);
+}
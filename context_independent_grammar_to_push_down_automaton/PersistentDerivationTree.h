@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CompactDerivationTree.h"
+#include "SymbolTable.h"
+
+// Immutable derivation tree for searches that branch on every expansion. All the versions grown from one
+// start symbol share an append-only arena of nodes; expanding a leaf copies only the nodes on the path from
+// the root to it (each with its list of children) and shares every other subtree with the tree it came
+// from. A new derivation costs O(depth * children per node + |right part|), and the arena grows with the
+// number of distinct expansions rather than with the size of full copies.
+//
+// Expand appends to the shared arena, so versions of one family must be expanded from one thread at a time.
+class PersistentDerivationTree
+{
+public:
+	using Symbol = SymbolTable::Symbol;
+	using SymbolString = SymbolTable::SymbolString;
+
+public:
+	static constexpr uint32_t kNoNode = UINT32_MAX;
+	static constexpr Symbol kLambdaSymbol = 0; // the id every grammar gives lambda
+
+public:
+	struct Node
+	{
+		Symbol symbol;
+		uint32_t firstChild; // the children are [firstChild, firstChild + childrenCount) in the children pool
+		uint32_t childrenCount;
+		uint32_t leavesCount; // of the subtree, so a leaf can be found by its position
+	};
+
+public:
+	PersistentDerivationTree();
+	PersistentDerivationTree(Symbol startSymbol);
+
+public:
+	bool operator ==(const PersistentDerivationTree& derivationTree) const;
+
+public:
+	PersistentDerivationTree Expand(size_t leaf, const SymbolString& right) const; // an empty right part gives a lambda leaf
+
+public:
+	uint32_t GetRoot() const; // kNoNode for an empty tree
+	const Node& GetNode(uint32_t node) const;
+	uint32_t GetChild(uint32_t node, size_t index) const;
+	size_t GetLeavesCount() const;
+	Symbol GetLeaf(size_t leaf) const; // O(depth)
+	SymbolString GetResult() const;
+	std::string GetResult(const SymbolTable& symbolTable) const;
+	size_t GetArenaSize() const; // nodes held by the whole family of versions
+	bool Empty() const;
+
+public:
+	CompactDerivationTree ToCompactDerivationTree() const;
+
+private:
+	struct Arena
+	{
+		std::vector<Node> nodes;
+		std::vector<uint32_t> children;
+	};
+
+private:
+	PersistentDerivationTree(std::shared_ptr<Arena> arena, uint32_t root);
+
+private:
+	uint32_t mf_AddNode(Symbol symbol, uint32_t firstChild, uint32_t childrenCount, uint32_t leavesCount) const;
+
+private:
+	std::shared_ptr<Arena> m_arena;
+	uint32_t m_root;
+};
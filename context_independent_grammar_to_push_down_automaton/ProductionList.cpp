@@ -0,0 +1,295 @@
+#include "ProductionList.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <functional>
+
+ProductionList::Iterator::Iterator(const ProductionList& productionList, size_t index)
+	: m_productionList(&productionList)
+	, m_index(index)
+{
+	/* EMPTY */
+}
+
+ProductionList::ProductionView ProductionList::Iterator::operator*() const
+{
+	return (*m_productionList)[m_index];
+}
+
+ProductionList::Iterator& ProductionList::Iterator::operator++()
+{
+	++m_index;
+	return *this;
+}
+
+bool ProductionList::Iterator::operator==(const Iterator& iterator) const
+{
+	return m_index == iterator.m_index;
+}
+
+ProductionList::ProductionList()
+	: m_unusedSymbols(0)
+{
+	/* EMPTY */
+}
+
+ProductionList::ProductionList(const ProductionList& productionList)
+	: m_unusedSymbols(0)
+{
+	*this = productionList;
+}
+
+ProductionList::ProductionList(ProductionList&& productionList) noexcept
+	: m_unusedSymbols(0)
+{
+	*this = std::move(productionList);
+}
+
+ProductionList& ProductionList::operator=(const ProductionList& productionList)
+{
+	if (this == &productionList) {
+		return *this;
+	}
+	// A mapped image is shared, not copied, until one of the lists changes.
+	m_image = productionList.m_image;
+	m_ownedSymbols = productionList.m_ownedSymbols;
+	m_ownedBounds = productionList.m_ownedBounds;
+	m_unusedSymbols = productionList.m_unusedSymbols;
+	if (m_image) {
+		m_symbols = productionList.m_symbols;
+		m_bounds = productionList.m_bounds;
+	}
+	else {
+		mf_ViewOwned();
+	}
+	return *this;
+}
+
+ProductionList& ProductionList::operator=(ProductionList&& productionList) noexcept
+{
+	if (this == &productionList) {
+		return *this;
+	}
+	m_image = std::move(productionList.m_image);
+	m_ownedSymbols = std::move(productionList.m_ownedSymbols);
+	m_ownedBounds = std::move(productionList.m_ownedBounds);
+	m_unusedSymbols = productionList.m_unusedSymbols;
+	if (m_image) {
+		m_symbols = productionList.m_symbols;
+		m_bounds = productionList.m_bounds;
+	}
+	else {
+		mf_ViewOwned();
+	}
+	productionList.m_ownedSymbols.clear();
+	productionList.m_ownedBounds.clear();
+	productionList.m_unusedSymbols = 0;
+	productionList.mf_ViewOwned();
+	return *this;
+}
+
+bool ProductionList::operator==(const ProductionList& productionList) const
+{
+	if (m_bounds.size() != productionList.m_bounds.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < m_bounds.size(); ++i) {
+		if ((*this)[i] != productionList[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+ProductionList::ProductionView ProductionList::operator[](size_t index) const
+{
+	const Bounds& bounds = m_bounds[index];
+	return { SymbolStringView(m_symbols.data() + bounds.leftBegin, bounds.leftLength), SymbolStringView(m_symbols.data() + bounds.rightBegin, bounds.rightLength) };
+}
+
+ProductionList::Iterator ProductionList::begin() const
+{
+	return Iterator(*this, 0);
+}
+
+ProductionList::Iterator ProductionList::end() const
+{
+	return Iterator(*this, m_bounds.size());
+}
+
+size_t ProductionList::Size() const
+{
+	return m_bounds.size();
+}
+
+bool ProductionList::Empty() const
+{
+	return m_bounds.empty();
+}
+
+void ProductionList::Reserve(size_t productionsCount, size_t symbolsCount)
+{
+	mf_Own();
+	m_ownedBounds.reserve(productionsCount);
+	m_ownedSymbols.reserve(symbolsCount);
+	mf_ViewOwned();
+}
+
+size_t ProductionList::Add(SymbolStringView left, SymbolStringView right)
+{
+	const std::shared_ptr<const MappedFile> image = mf_Own();
+	mf_MakeRoom(left.size() + right.size(), left, right);
+	Bounds bounds;
+	bounds.leftBegin = static_cast<uint32_t>(m_ownedSymbols.size());
+	bounds.leftLength = static_cast<uint32_t>(left.size());
+	bounds.rightBegin = bounds.leftBegin + bounds.leftLength;
+	bounds.rightLength = static_cast<uint32_t>(right.size());
+	// There is room for both parts, so pushing does not move a part that is a view into the symbols.
+	for (Symbol symbol : left) {
+		m_ownedSymbols.push_back(symbol);
+	}
+	for (Symbol symbol : right) {
+		m_ownedSymbols.push_back(symbol);
+	}
+	m_ownedBounds.push_back(bounds);
+	mf_ViewOwned();
+	return m_ownedBounds.size() - 1;
+}
+
+void ProductionList::SetRightPart(size_t index, SymbolStringView right)
+{
+	const std::shared_ptr<const MappedFile> image = mf_Own();
+	SymbolStringView none;
+	mf_MakeRoom(right.size(), right, none);
+	Bounds& bounds = m_ownedBounds[index];
+	m_unusedSymbols += bounds.rightLength;
+	bounds.rightLength = static_cast<uint32_t>(right.size());
+	bounds.rightBegin = mf_Append(right);
+	if (m_unusedSymbols > m_ownedSymbols.size() / 2) {
+		mf_Compact();
+	}
+	mf_ViewOwned();
+}
+
+void ProductionList::Remove(size_t index)
+{
+	mf_Own();
+	m_unusedSymbols += m_ownedBounds[index].leftLength + m_ownedBounds[index].rightLength;
+	m_ownedBounds[index] = m_ownedBounds.back();
+	m_ownedBounds.pop_back();
+	if (m_unusedSymbols > m_ownedSymbols.size() / 2) {
+		mf_Compact();
+	}
+	mf_ViewOwned();
+}
+
+void ProductionList::Clear()
+{
+	m_image.reset();
+	m_ownedSymbols.clear();
+	m_ownedBounds.clear();
+	m_unusedSymbols = 0;
+	mf_ViewOwned();
+}
+
+std::span<const ProductionList::Symbol> ProductionList::GetSymbols() const
+{
+	return m_symbols;
+}
+
+std::span<const ProductionList::Bounds> ProductionList::GetBounds() const
+{
+	return m_bounds;
+}
+
+void ProductionList::Assign(std::span<const Symbol> symbols, std::span<const Bounds> bounds)
+{
+	m_image.reset();
+	m_ownedSymbols.assign(symbols.begin(), symbols.end());
+	m_ownedBounds.assign(bounds.begin(), bounds.end());
+	mf_ViewOwned();
+	m_unusedSymbols = 0;
+	for (const Bounds& production : m_bounds) {
+		m_unusedSymbols += production.leftLength + production.rightLength;
+	}
+	m_unusedSymbols = m_symbols.size() - std::min(m_unusedSymbols, m_symbols.size());
+}
+
+void ProductionList::Assign(std::span<const Symbol> symbols, std::span<const Bounds> bounds, std::shared_ptr<const MappedFile> image)
+{
+	Clear();
+	m_image = std::move(image);
+	m_symbols = symbols;
+	m_bounds = bounds;
+	for (const Bounds& production : m_bounds) {
+		m_unusedSymbols += production.leftLength + production.rightLength;
+	}
+	m_unusedSymbols = m_symbols.size() - std::min(m_unusedSymbols, m_symbols.size());
+}
+
+void ProductionList::mf_MakeRoom(size_t symbolsCount, SymbolStringView& first, SymbolStringView& second)
+{
+	// A part that is a view into m_symbols is moved along with it when the array grows.
+	if (m_ownedSymbols.size() + symbolsCount > UINT32_MAX) {
+		throw "The productions have too many symbols.";
+	}
+	if (m_ownedSymbols.size() + symbolsCount <= m_ownedSymbols.capacity()) {
+		return;
+	}
+	const Symbol* oldBegin = m_ownedSymbols.data();
+	const Symbol* oldEnd = oldBegin + m_ownedSymbols.size();
+	auto isInside = [oldBegin, oldEnd](SymbolStringView part) {
+		return !part.empty() && !std::less<const Symbol*>()(part.data(), oldBegin) && std::less<const Symbol*>()(part.data(), oldEnd);
+	};
+	const bool firstIsInside = isInside(first);
+	const bool secondIsInside = isInside(second);
+	m_ownedSymbols.reserve(std::max(m_ownedSymbols.size() + symbolsCount, m_ownedSymbols.capacity() * 2));
+	if (firstIsInside) {
+		first = SymbolStringView(m_ownedSymbols.data() + (first.data() - oldBegin), first.size());
+	}
+	if (secondIsInside) {
+		second = SymbolStringView(m_ownedSymbols.data() + (second.data() - oldBegin), second.size());
+	}
+}
+
+uint32_t ProductionList::mf_Append(SymbolStringView symbols)
+{
+	// resize and copy rather than insert, which does not allow a range of the vector itself; mf_MakeRoom has
+	// made room, so the resize leaves such a range where it is.
+	const uint32_t begin = static_cast<uint32_t>(m_ownedSymbols.size());
+	m_ownedSymbols.resize(m_ownedSymbols.size() + symbols.size());
+	std::copy(symbols.begin(), symbols.end(), m_ownedSymbols.begin() + begin);
+	return begin;
+}
+
+void ProductionList::mf_Compact()
+{
+	std::vector<Symbol> symbols;
+	symbols.reserve(m_ownedSymbols.size() - m_unusedSymbols);
+	for (Bounds& bounds : m_ownedBounds) {
+		const uint32_t leftBegin = static_cast<uint32_t>(symbols.size());
+		symbols.insert(symbols.end(), m_ownedSymbols.begin() + bounds.leftBegin, m_ownedSymbols.begin() + bounds.leftBegin + bounds.leftLength);
+		const uint32_t rightBegin = static_cast<uint32_t>(symbols.size());
+		symbols.insert(symbols.end(), m_ownedSymbols.begin() + bounds.rightBegin, m_ownedSymbols.begin() + bounds.rightBegin + bounds.rightLength);
+		bounds.leftBegin = leftBegin;
+		bounds.rightBegin = rightBegin;
+	}
+	m_ownedSymbols = std::move(symbols);
+	m_unusedSymbols = 0;
+}
+
+std::shared_ptr<const MappedFile> ProductionList::mf_Own()
+{
+	if (!m_image) {
+		return nullptr;
+	}
+	m_ownedSymbols.assign(m_symbols.begin(), m_symbols.end());
+	m_ownedBounds.assign(m_bounds.begin(), m_bounds.end());
+	mf_ViewOwned();
+	return std::move(m_image);
+}
+
+void ProductionList::mf_ViewOwned()
+{
+	m_symbols = m_ownedSymbols;
+	m_bounds = m_ownedBounds;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "SymbolTable.h"
+
+class MappedFile;
+
+// The productions of a grammar, stored flat: the symbols of all of them in one array and, per production,
+// where its left and right parts are in it. A production is read as a pair of views into that array, so
+// reading, indexing and verifying a grammar touch no string of its own per part. A replaced or removed
+// part leaves its symbols behind until they are half of the array, then the array is compacted. A list
+// loaded from a mapped binary image reads both arrays in place and copies them out before its first change.
+class ProductionList
+{
+public:
+	using Symbol = SymbolTable::Symbol;
+	using SymbolStringView = SymbolTable::SymbolStringView;
+	using ProductionView = std::pair<SymbolStringView, SymbolStringView>; // left, right
+
+public:
+	struct Bounds
+	{
+		uint32_t leftBegin;
+		uint32_t leftLength;
+		uint32_t rightBegin;
+		uint32_t rightLength;
+	};
+
+	class Iterator
+	{
+	public:
+		Iterator(const ProductionList& productionList, size_t index);
+
+	public:
+		ProductionView operator *() const;
+		Iterator& operator ++();
+		bool operator ==(const Iterator& iterator) const;
+
+	private:
+		const ProductionList* m_productionList;
+		size_t m_index;
+	};
+
+public:
+	ProductionList();
+	ProductionList(const ProductionList& productionList);
+	ProductionList(ProductionList&& productionList) noexcept;
+
+public:
+	ProductionList& operator =(const ProductionList& productionList);
+	ProductionList& operator =(ProductionList&& productionList) noexcept;
+	bool operator ==(const ProductionList& productionList) const; // the same productions in the same order
+	ProductionView operator [](size_t index) const;
+
+public:
+	Iterator begin() const;
+	Iterator end() const;
+	size_t Size() const;
+	bool Empty() const;
+
+public:
+	void Reserve(size_t productionsCount, size_t symbolsCount);
+	size_t Add(SymbolStringView left, SymbolStringView right); // the parts may be views into this list
+	void SetRightPart(size_t index, SymbolStringView right);
+	void Remove(size_t index); // the last production takes its index
+	void Clear();
+
+public:
+	std::span<const Symbol> GetSymbols() const; // with the unused symbols, see GetBounds
+	std::span<const Bounds> GetBounds() const;
+	void Assign(std::span<const Symbol> symbols, std::span<const Bounds> bounds); // bounds must be within symbols
+	void Assign(std::span<const Symbol> symbols, std::span<const Bounds> bounds, std::shared_ptr<const MappedFile> image); // the spans are into image
+
+private:
+	void mf_MakeRoom(size_t symbolsCount, SymbolStringView& first, SymbolStringView& second);
+	uint32_t mf_Append(SymbolStringView symbols); // after mf_MakeRoom
+	void mf_Compact();
+	std::shared_ptr<const MappedFile> mf_Own(); // before a change, copies the arrays out of a mapped image and hands it over, for parts that are views into it
+	void mf_ViewOwned(); // after a change, points the spans at the owned vectors
+
+private:
+	// The arrays are read through the spans, which point into the vectors or into m_image.
+	std::span<const Symbol> m_symbols;
+	std::span<const Bounds> m_bounds;
+	std::shared_ptr<const MappedFile> m_image;
+	std::vector<Symbol> m_ownedSymbols;
+	std::vector<Bounds> m_ownedBounds;
+	size_t m_unusedSymbols;
+};
@@ -1,28 +1,176 @@
 #include "PushDownAutomaton.h"
+#include "BinaryFormat.h"
+#include "InputSplitter.h"
+#include "MappedFile.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <numeric>
+#include <utility>
 
 PushDownAutomaton::PushDownAutomaton()
+	: m_deltaIsBuilt(true)
 {
-	/* EMPTY */
+	mf_CompileTransitions();
+}
+PushDownAutomaton::PushDownAutomaton(const Grammar& grammar)
+	: m_initialState("q")
+	, m_stackStartSymbol(grammar.GetSymbolTable().GetName(grammar.GetStartSymbol()))
+	, m_deltaIsBuilt(true)
+{
+	const std::string lambda(1, kLambda);
+	const SymbolTable& symbolTable = grammar.GetSymbolTable();
+
+	m_states.insert(m_initialState);
+	for (Grammar::Symbol symbol : grammar.GetTerminalSymbols()) {
+		m_alphabet.insert(symbolTable.GetName(symbol));
+	}
+	for (Grammar::Symbol symbol : grammar.GetNonterminalSymbols()) {
+		m_stackAlphabet.insert(symbolTable.GetName(symbol));
+	}
+
+	// Pushed symbols are space separated as soon as one stack symbol name is longer than one character,
+	// the way mf_AppendPushedSymbols and mf_RebuildDelta read and write them.
+	bool separated = false;
+	for (const std::string& name : m_stackAlphabet) {
+		separated = separated || name.size() != 1;
+	}
+	auto pushedString = [&symbolTable, separated](Grammar::SymbolStringView symbols) {
+		std::string result;
+		for (size_t i = 0; i < symbols.size(); ++i) {
+			if (separated && i) {
+				result.push_back(' ');
+			}
+			result += symbolTable.GetName(symbols[i]);
+		}
+		return result;
+	};
+
+	// A ---> aX1...Xn becomes (q, A, a) = (q, X1...Xn); the automaton accepts by empty stack.
+	for (const auto& [left, right] : grammar.GetProductions()) {
+		if (left.size() != 1 || right.empty()) {
+			throw "The grammar is not in Greibach normal form.";
+		}
+		const std::string& leftName = symbolTable.GetName(left[0]);
+		if (right.size() == 1 && right[0] == Grammar::kLambdaSymbol) {
+			m_delta[m_initialState][leftName][lambda].emplace_back(m_initialState, lambda);
+			continue;
+		}
+		const std::string& inputSymbol = symbolTable.GetName(right[0]);
+		if (!m_alphabet.count(inputSymbol)) {
+			throw "The grammar is not in Greibach normal form.";
+		}
+		m_delta[m_initialState][leftName][inputSymbol].emplace_back(m_initialState, right.size() > 1 ? pushedString(right.substr(1)) : lambda);
+	}
+
+	mf_CompileTransitions();
 }
 PushDownAutomaton::PushDownAutomaton(const PushDownAutomaton& pushDownAutomaton)
+	: m_deltaIsBuilt(true)
 {
 	*this = pushDownAutomaton;
 }
 
+PushDownAutomaton::PushDownAutomaton(PushDownAutomaton&& pushDownAutomaton) noexcept
+	: m_deltaIsBuilt(true)
+{
+	*this = std::move(pushDownAutomaton);
+}
+
 PushDownAutomaton& PushDownAutomaton::operator=(const PushDownAutomaton& pushDownAutomaton)
 {
-	m_states = pushDownAutomaton.m_states;
-	m_alphabet = pushDownAutomaton.m_alphabet;
-	m_stackAlphabet = pushDownAutomaton.m_stackAlphabet;
-	m_initialState = pushDownAutomaton.m_initialState;
-	m_stackStartSymbol = pushDownAutomaton.m_stackStartSymbol;
-	m_finalStates = pushDownAutomaton.m_finalStates;
-	m_delta = pushDownAutomaton.m_delta;
+	if (this == &pushDownAutomaton) {
+		return *this;
+	}
+	// The string view is copied only if the source has built it; otherwise the copy builds its own.
+	const bool deltaIsBuilt = pushDownAutomaton.m_deltaIsBuilt.load(std::memory_order_acquire);
+	m_states = deltaIsBuilt ? pushDownAutomaton.m_states : std::unordered_set<std::string>();
+	m_alphabet = deltaIsBuilt ? pushDownAutomaton.m_alphabet : std::unordered_set<std::string>();
+	m_stackAlphabet = deltaIsBuilt ? pushDownAutomaton.m_stackAlphabet : std::unordered_set<std::string>();
+	m_initialState = deltaIsBuilt ? pushDownAutomaton.m_initialState : std::string();
+	m_stackStartSymbol = deltaIsBuilt ? pushDownAutomaton.m_stackStartSymbol : std::string();
+	m_finalStates = deltaIsBuilt ? pushDownAutomaton.m_finalStates : std::unordered_set<std::string>();
+	m_delta = deltaIsBuilt ? pushDownAutomaton.m_delta : DeltaFunctionDefiniton();
+	m_deltaIsBuilt.store(deltaIsBuilt, std::memory_order_release);
+	m_stateNames = pushDownAutomaton.m_stateNames;
+	m_stackSymbolNames = pushDownAutomaton.m_stackSymbolNames;
+	m_inputSymbolNames = pushDownAutomaton.m_inputSymbolNames;
+	m_inputSymbolIndexes = pushDownAutomaton.m_inputSymbolIndexes;
+	m_hasLongInputSymbols = pushDownAutomaton.m_hasLongInputSymbols;
+	m_unusedTransitions = pushDownAutomaton.m_unusedTransitions;
+	m_unusedPushedSymbols = pushDownAutomaton.m_unusedPushedSymbols;
+	m_initialStateIndex = pushDownAutomaton.m_initialStateIndex;
+	m_stackStartSymbolIndex = pushDownAutomaton.m_stackStartSymbolIndex;
+	m_pushers = pushDownAutomaton.m_pushers;
+	m_pushersAreBuilt = pushDownAutomaton.m_pushersAreBuilt;
+	// A mapped image is shared, not copied, until one of the automata changes.
+	m_image = pushDownAutomaton.m_image;
+	m_ownedTransitionOffsets = pushDownAutomaton.m_ownedTransitionOffsets;
+	m_ownedCompiledTransitions = pushDownAutomaton.m_ownedCompiledTransitions;
+	m_ownedPushedSymbols = pushDownAutomaton.m_ownedPushedSymbols;
+	m_ownedIsFinalState = pushDownAutomaton.m_ownedIsFinalState;
+	m_ownedMinimumInputToPop = pushDownAutomaton.m_ownedMinimumInputToPop;
+	if (m_image) {
+		m_transitionOffsets = pushDownAutomaton.m_transitionOffsets;
+		m_compiledTransitions = pushDownAutomaton.m_compiledTransitions;
+		m_pushedSymbols = pushDownAutomaton.m_pushedSymbols;
+		m_isFinalState = pushDownAutomaton.m_isFinalState;
+		m_minimumInputToPop = pushDownAutomaton.m_minimumInputToPop;
+	}
+	else {
+		mf_ViewOwnedTables();
+	}
+	return *this;
+}
+
+PushDownAutomaton& PushDownAutomaton::operator=(PushDownAutomaton&& pushDownAutomaton) noexcept
+{
+	if (this == &pushDownAutomaton) {
+		return *this;
+	}
+	m_states = std::move(pushDownAutomaton.m_states);
+	m_alphabet = std::move(pushDownAutomaton.m_alphabet);
+	m_stackAlphabet = std::move(pushDownAutomaton.m_stackAlphabet);
+	m_initialState = std::move(pushDownAutomaton.m_initialState);
+	m_stackStartSymbol = std::move(pushDownAutomaton.m_stackStartSymbol);
+	m_finalStates = std::move(pushDownAutomaton.m_finalStates);
+	m_delta = std::move(pushDownAutomaton.m_delta);
+	m_deltaIsBuilt.store(pushDownAutomaton.m_deltaIsBuilt.load(std::memory_order_acquire), std::memory_order_release);
+	m_stateNames = std::move(pushDownAutomaton.m_stateNames);
+	m_stackSymbolNames = std::move(pushDownAutomaton.m_stackSymbolNames);
+	m_inputSymbolNames = std::move(pushDownAutomaton.m_inputSymbolNames);
+	m_inputSymbolIndexes = pushDownAutomaton.m_inputSymbolIndexes;
+	m_hasLongInputSymbols = pushDownAutomaton.m_hasLongInputSymbols;
+	m_unusedTransitions = pushDownAutomaton.m_unusedTransitions;
+	m_unusedPushedSymbols = pushDownAutomaton.m_unusedPushedSymbols;
+	m_initialStateIndex = pushDownAutomaton.m_initialStateIndex;
+	m_stackStartSymbolIndex = pushDownAutomaton.m_stackStartSymbolIndex;
+	m_pushers = std::move(pushDownAutomaton.m_pushers);
+	m_pushersAreBuilt = pushDownAutomaton.m_pushersAreBuilt;
+	pushDownAutomaton.m_pushersAreBuilt = false;
+	m_image = std::move(pushDownAutomaton.m_image);
+	m_ownedTransitionOffsets = std::move(pushDownAutomaton.m_ownedTransitionOffsets);
+	m_ownedCompiledTransitions = std::move(pushDownAutomaton.m_ownedCompiledTransitions);
+	m_ownedPushedSymbols = std::move(pushDownAutomaton.m_ownedPushedSymbols);
+	m_ownedIsFinalState = std::move(pushDownAutomaton.m_ownedIsFinalState);
+	m_ownedMinimumInputToPop = std::move(pushDownAutomaton.m_ownedMinimumInputToPop);
+	if (m_image) {
+		m_transitionOffsets = pushDownAutomaton.m_transitionOffsets;
+		m_compiledTransitions = pushDownAutomaton.m_compiledTransitions;
+		m_pushedSymbols = pushDownAutomaton.m_pushedSymbols;
+		m_isFinalState = pushDownAutomaton.m_isFinalState;
+		m_minimumInputToPop = pushDownAutomaton.m_minimumInputToPop;
+	}
+	else {
+		mf_ViewOwnedTables();
+	}
+	pushDownAutomaton.mf_ViewOwnedTables();
 	return *this;
 }
 
 bool PushDownAutomaton::operator==(const PushDownAutomaton& pushDownAutomaton)
 {
+	mf_EnsureDelta();
+	pushDownAutomaton.mf_EnsureDelta();
 	return m_states == pushDownAutomaton.m_states
 		&& m_alphabet == pushDownAutomaton.m_alphabet
 		&& m_stackAlphabet == pushDownAutomaton.m_stackAlphabet
@@ -32,8 +180,865 @@ bool PushDownAutomaton::operator==(const PushDownAutomaton& pushDownAutomaton)
 		&& m_delta == pushDownAutomaton.m_delta;
 }
 
+bool PushDownAutomaton::Accepts(std::string_view word, AcceptanceMode mode) const
+{
+	AcceptanceContext context;
+	return Accepts(word, context, mode);
+}
+
+bool PushDownAutomaton::Accepts(std::string_view word, AcceptanceContext& context, AcceptanceMode mode) const
+{
+	auto& input = context.m_input;
+	context.m_matchOffsets.clear();
+	if (m_hasLongInputSymbols) {
+		mf_MatchInputSymbols(word, context);
+		return mf_AcceptsInput(context, mode);
+	}
+	input.clear();
+	for (char character : word) {
+		const uint32_t inputSymbol = GetInputSymbolIndex(character);
+		if (inputSymbol == kNoSymbol) {
+			return false;
+		}
+		input.push_back(inputSymbol);
+	}
+	return mf_AcceptsInput(context, mode);
+}
+
+bool PushDownAutomaton::Accepts(std::span<const uint32_t> inputSymbols, AcceptanceMode mode) const
+{
+	AcceptanceContext context;
+	return Accepts(inputSymbols, context, mode);
+}
+
+bool PushDownAutomaton::Accepts(std::span<const uint32_t> inputSymbols, AcceptanceContext& context, AcceptanceMode mode) const
+{
+	for (uint32_t inputSymbol : inputSymbols) {
+		if (inputSymbol == 0 || inputSymbol >= m_inputSymbolNames.size()) {
+			return false;
+		}
+	}
+	context.m_input.assign(inputSymbols.begin(), inputSymbols.end());
+	context.m_matchOffsets.clear();
+	return mf_AcceptsInput(context, mode);
+}
+
+bool PushDownAutomaton::mf_AcceptsInput(AcceptanceContext& context, AcceptanceMode mode) const
+{
+	if (m_initialStateIndex == kNoSymbol || m_stackStartSymbolIndex == kNoSymbol) {
+		return false;
+	}
+	// A word split by names is read by characters: reading an input symbol at a position moves past its
+	// name, so every split of the word is followed at once.
+	const auto& input = context.m_input;
+	const auto& matchOffsets = context.m_matchOffsets;
+	const auto& matches = context.m_matches;
+	const bool isSplit = !matchOffsets.empty();
+	const size_t inputLength = isSplit ? matchOffsets.size() - 1 : input.size();
+	const size_t statesCount = m_stateNames.size();
+	if ((inputLength + 1) * statesCount >= kNoSymbol) {
+		throw "The word is too long.";
+	}
+
+	auto& nodes = context.m_nodes;
+	auto& returns = context.m_returns;
+	auto& links = context.m_links;
+	auto& steps = context.m_steps;
+	nodes.clear();
+	returns.clear();
+	links.clear();
+	steps.clear();
+	context.m_nodeIndexes.Clear();
+	context.m_seenReturns.Clear();
+	context.m_seenPops.Clear();
+
+	// Nodes, returns and pops are finite, at most one per (symbol, state, position) and so on, so the search
+	// ends even when lambda moves keep pushing; in EmptyStack mode the pushed symbols that need more input
+	// to be popped than what is left are not followed at all. Every name is at least one character, so the
+	// characters left bound the input symbols left.
+	const bool emptyStack = mode == AcceptanceMode::EmptyStack;
+	auto isAccepting = [this, inputLength, statesCount, emptyStack](uint32_t configuration, bool stackIsEmpty) {
+		return configuration / statesCount == inputLength && (emptyStack ? stackIsEmpty : m_isFinalState[configuration % statesCount] != 0);
+	};
+	auto addLink = [&links](uint32_t& first, uint32_t value) {
+		links.push_back({ value, first });
+		first = static_cast<uint32_t>(links.size() - 1);
+	};
+
+	// The node of (symbol, configuration), expanded when it is new: every transition of it gets one return
+	// per pushed symbol, plus the one it starts from, and that first return is taken at once.
+	auto getNode = [&](uint32_t symbol, uint32_t configuration, bool& isNew) {
+		const uint64_t key = static_cast<uint64_t>(configuration) * m_stackSymbolNames.size() + symbol;
+		const uint32_t newIndex = static_cast<uint32_t>(nodes.size());
+		const uint32_t existingIndex = context.m_nodeIndexes.Insert(key, newIndex);
+		isNew = existingIndex == StampedHashMap::kNotFound;
+		if (!isNew) {
+			return existingIndex;
+		}
+		nodes.push_back({ symbol, configuration, kNoSymbol, kNoSymbol });
+		const uint32_t state = configuration % statesCount;
+		const uint32_t position = configuration / statesCount;
+		auto expand = [&](uint32_t inputSymbol, uint32_t nextPosition) {
+			const CompiledTransition* begin = TransitionsBegin(state, symbol, inputSymbol);
+			for (auto it = begin, end = TransitionsEnd(state, symbol, inputSymbol); it != end; ++it) {
+				const uint32_t transition = static_cast<uint32_t>(it - m_compiledTransitions.data());
+				steps.push_back({ static_cast<uint32_t>(returns.size()), static_cast<uint32_t>(nextPosition * statesCount + it->state) });
+				for (uint32_t popped = 0; popped <= it->pushLength; ++popped) {
+					returns.push_back({ transition, popped, newIndex });
+				}
+			}
+		};
+		expand(0, position);
+		if (position == inputLength) {
+			return newIndex;
+		}
+		if (isSplit) {
+			for (uint32_t i = matchOffsets[position]; i < matchOffsets[position + 1]; ++i) {
+				expand(matches[i].inputSymbol, position + matches[i].length);
+			}
+		}
+		else {
+			expand(input[position], position + 1);
+		}
+		return newIndex;
+	};
+	auto addReturn = [&](uint32_t node, uint32_t returnIndex) {
+		if (context.m_seenReturns.Insert((static_cast<uint64_t>(node) << 32) | returnIndex, 0) != StampedHashMap::kNotFound) {
+			return;
+		}
+		addLink(nodes[node].firstReturn, returnIndex);
+		for (uint32_t link = nodes[node].firstPop; link != kNoSymbol; link = links[link].next) {
+			steps.push_back({ returnIndex, links[link].value });
+		}
+	};
+	auto addPop = [&](uint32_t node, uint32_t configuration) {
+		if (context.m_seenPops.Insert((static_cast<uint64_t>(node) << 32) | configuration, 0) != StampedHashMap::kNotFound) {
+			return;
+		}
+		addLink(nodes[node].firstPop, configuration);
+		for (uint32_t link = nodes[node].firstReturn; link != kNoSymbol; link = links[link].next) {
+			steps.push_back({ links[link].value, configuration });
+		}
+	};
+
+	if (emptyStack && m_minimumInputToPop[m_stackStartSymbolIndex] > inputLength) {
+		return false;
+	}
+	bool isNew;
+	returns.push_back({ kNoSymbol, 0, kNoSymbol });
+	const uint32_t startNode = getNode(m_stackStartSymbolIndex, m_initialStateIndex, isNew);
+	if (!emptyStack && isAccepting(m_initialStateIndex, false)) {
+		return true;
+	}
+	addReturn(startNode, 0);
+
+	// A step is a return taken from a configuration: the next pushed symbol gets its node there, or, when
+	// they are all popped, the node the transition replaced is popped there.
+	while (!steps.empty()) {
+		const auto [returnIndex, configuration] = steps.back();
+		steps.pop_back();
+		const AcceptanceContext::Return taken = returns[returnIndex];
+		if (taken.transition == kNoSymbol) {
+			if (isAccepting(configuration, true)) {
+				return true;
+			}
+			continue;
+		}
+		const CompiledTransition& transition = m_compiledTransitions[taken.transition];
+		if (taken.popped == transition.pushLength) {
+			addPop(taken.node, configuration);
+			continue;
+		}
+		const uint32_t* pushed = PushedSymbols(transition);
+		if (emptyStack) {
+			uint64_t minimumInput = 0;
+			for (uint32_t i = taken.popped; i < transition.pushLength; ++i) {
+				minimumInput += m_minimumInputToPop[pushed[i]];
+			}
+			if (minimumInput > inputLength - configuration / statesCount) {
+				continue;
+			}
+		}
+		const uint32_t node = getNode(pushed[taken.popped], configuration, isNew);
+		if (isNew && !emptyStack && isAccepting(configuration, false)) {
+			return true;
+		}
+		addReturn(node, returnIndex + 1);
+	}
+	return false;
+}
+
+std::vector<uint64_t> PushDownAutomaton::AcceptsAll(std::span<const std::string> words, AcceptanceMode mode) const
+{
+	return mf_AcceptsAll(words, mode);
+}
+
+std::vector<uint64_t> PushDownAutomaton::AcceptsAll(std::span<const std::string_view> words, AcceptanceMode mode) const
+{
+	return mf_AcceptsAll(words, mode);
+}
+
+template <typename Word>
+std::vector<uint64_t> PushDownAutomaton::mf_AcceptsAll(std::span<const Word> words, AcceptanceMode mode) const
+{
+	// One chunk is one word of the bitmap, so no two workers ever write the same uint64_t.
+	const size_t chunksCount = (words.size() + 63) / 64;
+	std::vector<uint64_t> result(chunksCount, 0);
+	WorkStealingPool& pool = WorkStealingPool::GetShared();
+	std::vector<AcceptanceContext> contexts(pool.GetThreadsCount());
+
+	pool.Run(chunksCount, [this, words, mode, &result, &contexts](size_t workerIndex, size_t chunkIndex) {
+		AcceptanceContext& context = contexts[workerIndex];
+		const size_t begin = chunkIndex * 64;
+		const size_t end = std::min(begin + 64, words.size());
+		uint64_t bits = 0;
+		for (size_t i = begin; i < end; ++i) {
+			if (Accepts(words[i], context, mode)) {
+				bits |= uint64_t(1) << (i - begin);
+			}
+		}
+		result[chunkIndex] = bits;
+	});
+	return result;
+}
+
+void PushDownAutomaton::SaveBinary(std::ostream& out) const
+{
+	BinaryFormat::Writer writer(out, BinaryFormat::Kind::PushDownAutomaton);
+	writer.WriteStrings(m_stateNames);
+	writer.WriteStrings(m_stackSymbolNames);
+	writer.WriteStrings(m_inputSymbolNames);
+	writer.Write(m_initialStateIndex);
+	writer.Write(m_stackStartSymbolIndex);
+	writer.WriteArray(std::span<const uint32_t>(m_inputSymbolIndexes));
+	writer.WriteArray(m_transitionOffsets);
+	writer.WriteArray(m_compiledTransitions);
+	writer.WriteArray(m_pushedSymbols);
+	writer.WriteArray(m_isFinalState);
+	writer.WriteArray(m_minimumInputToPop);
+}
+
+void PushDownAutomaton::SaveBinary(const std::string& path) const
+{
+	std::ofstream out(path, std::ios::binary);
+	if (!out) {
+		throw "The file could not be opened.";
+	}
+	SaveBinary(out);
+}
+
+void PushDownAutomaton::LoadBinary(std::span<const uint8_t> bytes)
+{
+	mf_LoadBinary(bytes, nullptr);
+}
+
+void PushDownAutomaton::LoadBinary(const std::string& path)
+{
+	std::shared_ptr<const MappedFile> image = std::make_shared<MappedFile>(path);
+	mf_LoadBinary(image->GetBytes(), image);
+}
+
+void PushDownAutomaton::mf_LoadBinary(std::span<const uint8_t> bytes, std::shared_ptr<const MappedFile> image)
+{
+	BinaryFormat::Reader reader(bytes, BinaryFormat::Kind::PushDownAutomaton);
+	std::vector<std::string> stateNames = reader.ReadStrings();
+	std::vector<std::string> stackSymbolNames = reader.ReadStrings();
+	std::vector<std::string> inputSymbolNames = reader.ReadStrings();
+	const uint32_t initialStateIndex = reader.Read<uint32_t>();
+	const uint32_t stackStartSymbolIndex = reader.Read<uint32_t>();
+	const std::span<const uint32_t> inputSymbolIndexes = reader.ReadArray<uint32_t>();
+	const std::span<const uint32_t> transitionOffsets = reader.ReadArray<uint32_t>();
+	const std::span<const CompiledTransition> compiledTransitions = reader.ReadArray<CompiledTransition>();
+	const std::span<const uint32_t> pushedSymbols = reader.ReadArray<uint32_t>();
+	const std::span<const uint8_t> isFinalState = reader.ReadArray<uint8_t>();
+	const std::span<const uint32_t> minimumInputToPop = reader.ReadArray<uint32_t>();
+
+	// Everything Accepts indexes with is checked once here, so a damaged image cannot read out of bounds.
+	const size_t statesCount = stateNames.size();
+	const size_t stackSymbolsCount = stackSymbolNames.size();
+	const size_t inputSymbolsCount = inputSymbolNames.size();
+	auto isIndexOrNone = [](uint32_t index, size_t count) {
+		return index == kNoSymbol || index < count;
+	};
+	bool valid = inputSymbolsCount > 0 && inputSymbolIndexes.size() == m_inputSymbolIndexes.size()
+		&& transitionOffsets.size() == statesCount * stackSymbolsCount * (inputSymbolsCount + 1)
+		&& std::is_sorted(stateNames.begin(), stateNames.end()) && std::is_sorted(stackSymbolNames.begin(), stackSymbolNames.end())
+		&& isFinalState.size() == statesCount && minimumInputToPop.size() == stackSymbolsCount
+		&& isIndexOrNone(initialStateIndex, statesCount) && isIndexOrNone(stackStartSymbolIndex, stackSymbolsCount);
+	for (size_t i = 0; valid && i < inputSymbolIndexes.size(); ++i) {
+		valid = isIndexOrNone(inputSymbolIndexes[i], inputSymbolsCount);
+	}
+	// The blocks of an image saved after ReplaceTransitions may have holes between them, which are counted
+	// as unused.
+	size_t usedTransitions = 0;
+	size_t usedPushedSymbols = 0;
+	for (size_t block = 0; valid && block < transitionOffsets.size(); block += inputSymbolsCount + 1) {
+		const auto offsets = transitionOffsets.subspan(block, inputSymbolsCount + 1);
+		valid = std::is_sorted(offsets.begin(), offsets.end()) && offsets.back() <= compiledTransitions.size();
+		usedTransitions += valid ? offsets.back() - offsets.front() : 0;
+		for (uint32_t i = offsets.front(); valid && i < offsets.back(); ++i) {
+			usedPushedSymbols += compiledTransitions[i].pushLength;
+		}
+	}
+	for (size_t i = 0; valid && i < compiledTransitions.size(); ++i) {
+		const CompiledTransition& transition = compiledTransitions[i];
+		valid = transition.state < statesCount && transition.pushBegin <= pushedSymbols.size()
+			&& transition.pushLength <= pushedSymbols.size() - transition.pushBegin;
+	}
+	valid = valid && usedTransitions <= compiledTransitions.size() && usedPushedSymbols <= pushedSymbols.size();
+	for (size_t i = 0; valid && i < pushedSymbols.size(); ++i) {
+		valid = pushedSymbols[i] < stackSymbolsCount;
+	}
+	if (!valid) {
+		throw "The binary image is not valid.";
+	}
+
+	m_stateNames = std::move(stateNames);
+	m_stackSymbolNames = std::move(stackSymbolNames);
+	m_inputSymbolNames = std::move(inputSymbolNames);
+	m_initialStateIndex = initialStateIndex;
+	m_stackStartSymbolIndex = stackStartSymbolIndex;
+	std::copy(inputSymbolIndexes.begin(), inputSymbolIndexes.end(), m_inputSymbolIndexes.begin());
+	m_hasLongInputSymbols = std::any_of(m_inputSymbolNames.begin() + 1, m_inputSymbolNames.end(), [](const std::string& name) {
+		return name.size() != 1;
+	});
+	m_unusedTransitions = compiledTransitions.size() - usedTransitions;
+	m_unusedPushedSymbols = pushedSymbols.size() - usedPushedSymbols;
+	m_pushers.clear();
+	m_pushersAreBuilt = false;
+	// The tables of a mapped image are read where they are; bytes the caller owns are copied.
+	m_image = std::move(image);
+	m_ownedTransitionOffsets.clear();
+	m_ownedCompiledTransitions.clear();
+	m_ownedPushedSymbols.clear();
+	m_ownedIsFinalState.clear();
+	m_ownedMinimumInputToPop.clear();
+	if (m_image) {
+		m_transitionOffsets = transitionOffsets;
+		m_compiledTransitions = compiledTransitions;
+		m_pushedSymbols = pushedSymbols;
+		m_isFinalState = isFinalState;
+		m_minimumInputToPop = minimumInputToPop;
+	}
+	else {
+		m_ownedTransitionOffsets.assign(transitionOffsets.begin(), transitionOffsets.end());
+		m_ownedCompiledTransitions.assign(compiledTransitions.begin(), compiledTransitions.end());
+		m_ownedPushedSymbols.assign(pushedSymbols.begin(), pushedSymbols.end());
+		m_ownedIsFinalState.assign(isFinalState.begin(), isFinalState.end());
+		m_ownedMinimumInputToPop.assign(minimumInputToPop.begin(), minimumInputToPop.end());
+		mf_ViewOwnedTables();
+	}
+
+	m_states.clear();
+	m_alphabet.clear();
+	m_stackAlphabet.clear();
+	m_initialState.clear();
+	m_stackStartSymbol.clear();
+	m_finalStates.clear();
+	m_delta.clear();
+	m_deltaIsBuilt.store(false, std::memory_order_release);
+}
+
+void PushDownAutomaton::ReplaceTransitions(const std::string& state, const std::string& stackSymbol, std::unordered_map<std::string, DeltaResult> results)
+{
+	const std::string lambda(1, kLambda);
+	const uint32_t stateIndex = GetStateIndex(state);
+	const uint32_t stackSymbolIndex = GetStackSymbolIndex(stackSymbol);
+	if (stateIndex == kNoSymbol || stackSymbolIndex == kNoSymbol) {
+		throw "The transition uses a symbol that is not part of the automaton.";
+	}
+	mf_OwnTables();
+	const size_t inputSymbolsCount = m_inputSymbolNames.size();
+	std::vector<uint32_t> inputSymbolIndexes;
+	std::vector<uint32_t> cursors(inputSymbolsCount + 1, 0);
+	for (const auto& [inputSymbol, vectorOfPairs] : results) {
+		const uint32_t inputSymbolIndex = inputSymbol == lambda ? 0 : GetInputSymbolIndex(std::string_view(inputSymbol));
+		if (inputSymbolIndex == kNoSymbol) {
+			throw "The transition uses a symbol that is not part of the automaton.";
+		}
+		inputSymbolIndexes.push_back(inputSymbolIndex);
+		cursors[inputSymbolIndex + 1] += static_cast<uint32_t>(vectorOfPairs.size());
+	}
+	for (size_t i = 1; i < cursors.size(); ++i) {
+		cursors[i] += cursors[i - 1];
+	}
+
+	// The new transitions are one block, appended; the old block is left where it is as a hole, so no other
+	// offset moves.
+	std::vector<CompiledTransition> block(cursors.back());
+	std::vector<uint32_t> counts(cursors.begin(), cursors.end() - 1);
+	size_t entry = 0;
+	for (const auto& [inputSymbol, vectorOfPairs] : results) {
+		uint32_t& cursor = counts[inputSymbolIndexes[entry++]];
+		for (const auto& [nextState, pushedString] : vectorOfPairs) {
+			CompiledTransition transition;
+			transition.state = GetStateIndex(nextState);
+			transition.pushBegin = static_cast<uint32_t>(m_ownedPushedSymbols.size());
+			if (transition.state == kNoSymbol) {
+				throw "The transition uses a symbol that is not part of the automaton.";
+			}
+			if (pushedString != lambda) {
+				mf_AppendPushedSymbols(pushedString);
+			}
+			transition.pushLength = static_cast<uint32_t>(m_ownedPushedSymbols.size()) - transition.pushBegin;
+			block[cursor++] = transition;
+		}
+	}
+
+	mf_EnsurePushers();
+	const size_t firstSlot = mf_GetTransitionSlot(stateIndex, stackSymbolIndex, 0);
+	const uint32_t oldBegin = m_ownedTransitionOffsets[firstSlot];
+	const uint32_t oldEnd = m_ownedTransitionOffsets[firstSlot + inputSymbolsCount];
+	mf_IndexPushers(stackSymbolIndex, m_ownedCompiledTransitions.data() + oldBegin, m_ownedCompiledTransitions.data() + oldEnd, false);
+	mf_IndexPushers(stackSymbolIndex, block.data(), block.data() + block.size(), true);
+	for (uint32_t i = oldBegin; i < oldEnd; ++i) {
+		m_unusedPushedSymbols += m_ownedCompiledTransitions[i].pushLength;
+	}
+	m_unusedTransitions += oldEnd - oldBegin;
+	const uint32_t newBegin = static_cast<uint32_t>(m_ownedCompiledTransitions.size());
+	m_ownedCompiledTransitions.insert(m_ownedCompiledTransitions.end(), block.begin(), block.end());
+	for (size_t i = 0; i <= inputSymbolsCount; ++i) {
+		m_ownedTransitionOffsets[firstSlot + i] = newBegin + cursors[i];
+	}
+	if (m_unusedTransitions > m_ownedCompiledTransitions.size() / 2 || m_unusedPushedSymbols > m_ownedPushedSymbols.size() / 2) {
+		mf_CompactTables();
+	}
+	mf_ViewOwnedTables();
+
+	// Only stackSymbol and the symbols that push one of them, transitively, can get another minimum.
+	std::vector<uint8_t> isAffected(m_stackSymbolNames.size(), 0);
+	std::vector<uint32_t> affected{ stackSymbolIndex };
+	isAffected[stackSymbolIndex] = 1;
+	for (size_t i = 0; i < affected.size(); ++i) {
+		for (uint32_t pusher : m_pushers[affected[i]]) {
+			if (!isAffected[pusher]) {
+				isAffected[pusher] = 1;
+				affected.push_back(pusher);
+			}
+		}
+	}
+	mf_ComputeMinimumInputToPop(affected);
+
+	// A string view that is not built yet is built from the tables, which have the new transitions already.
+	if (!m_deltaIsBuilt.load(std::memory_order_acquire)) {
+		return;
+	}
+	if (results.empty()) {
+		auto it = m_delta.find(state);
+		if (it != m_delta.end()) {
+			it->second.erase(stackSymbol);
+		}
+	}
+	else {
+		m_delta[state][stackSymbol] = std::move(results);
+	}
+}
+
+uint32_t PushDownAutomaton::GetStateIndex(const std::string& state) const
+{
+	auto it = std::lower_bound(m_stateNames.begin(), m_stateNames.end(), state);
+	if (it == m_stateNames.end() || *it != state) {
+		return kNoSymbol;
+	}
+	return static_cast<uint32_t>(it - m_stateNames.begin());
+}
+
+uint32_t PushDownAutomaton::GetStackSymbolIndex(const std::string& stackSymbol) const
+{
+	auto it = std::lower_bound(m_stackSymbolNames.begin(), m_stackSymbolNames.end(), stackSymbol);
+	if (it == m_stackSymbolNames.end() || *it != stackSymbol) {
+		return kNoSymbol;
+	}
+	return static_cast<uint32_t>(it - m_stackSymbolNames.begin());
+}
+
+uint32_t PushDownAutomaton::GetInputSymbolIndex(char inputSymbol) const
+{
+	return m_inputSymbolIndexes[static_cast<unsigned char>(inputSymbol)];
+}
+
+uint32_t PushDownAutomaton::GetInputSymbolIndex(std::string_view inputSymbol) const
+{
+	// Index 0 is lambda; the names after it are sorted.
+	auto it = std::lower_bound(m_inputSymbolNames.begin() + 1, m_inputSymbolNames.end(), inputSymbol);
+	if (it == m_inputSymbolNames.end() || *it != inputSymbol) {
+		return kNoSymbol;
+	}
+	return static_cast<uint32_t>(it - m_inputSymbolNames.begin());
+}
+
+bool PushDownAutomaton::Tokenize(std::string_view word, std::vector<uint32_t>& inputSymbols) const
+{
+	inputSymbols.clear();
+	size_t position = 0;
+	while (position < word.size()) {
+		uint32_t match = kNoSymbol;
+		size_t matchLength = 0;
+		mf_ForEachInputSymbolAt(word, position, [&match, &matchLength](uint32_t inputSymbol, size_t length) {
+			match = inputSymbol;
+			matchLength = length;
+		});
+		if (match == kNoSymbol) {
+			return false;
+		}
+		inputSymbols.push_back(match);
+		position += matchLength;
+	}
+	return true;
+}
+
+void PushDownAutomaton::mf_MatchInputSymbols(std::string_view word, AcceptanceContext& context) const
+{
+	auto& matchOffsets = context.m_matchOffsets;
+	auto& matches = context.m_matches;
+	matchOffsets.clear();
+	matches.clear();
+	for (size_t position = 0; position < word.size(); ++position) {
+		matchOffsets.push_back(static_cast<uint32_t>(matches.size()));
+		mf_ForEachInputSymbolAt(word, position, [&matches](uint32_t inputSymbol, size_t length) {
+			matches.push_back({ inputSymbol, static_cast<uint32_t>(length) });
+		});
+	}
+	matchOffsets.push_back(static_cast<uint32_t>(matches.size()));
+}
+
+template <typename Visit>
+void PushDownAutomaton::mf_ForEachInputSymbolAt(std::string_view word, size_t position, Visit visit) const
+{
+	InputSplitter::ForEachNameAt(m_inputSymbolNames.begin() + 1, m_inputSymbolNames.end(), word, position, [this, &visit](auto name, size_t length) {
+		visit(static_cast<uint32_t>(name - m_inputSymbolNames.begin()), length);
+	});
+}
+
+const PushDownAutomaton::CompiledTransition* PushDownAutomaton::TransitionsBegin(uint32_t state, uint32_t stackSymbol, uint32_t inputSymbol) const
+{
+	return m_compiledTransitions.data() + m_transitionOffsets[mf_GetTransitionSlot(state, stackSymbol, inputSymbol)];
+}
+
+const PushDownAutomaton::CompiledTransition* PushDownAutomaton::TransitionsEnd(uint32_t state, uint32_t stackSymbol, uint32_t inputSymbol) const
+{
+	return m_compiledTransitions.data() + m_transitionOffsets[mf_GetTransitionSlot(state, stackSymbol, inputSymbol) + 1];
+}
+
+const uint32_t* PushDownAutomaton::PushedSymbols(const CompiledTransition& transition) const
+{
+	return m_pushedSymbols.data() + transition.pushBegin;
+}
+
+void PushDownAutomaton::mf_CompileTransitions()
+{
+	const std::string lambda(1, kLambda);
+
+	m_stateNames.assign(m_states.begin(), m_states.end());
+	std::sort(m_stateNames.begin(), m_stateNames.end());
+	m_stackSymbolNames.assign(m_stackAlphabet.begin(), m_stackAlphabet.end());
+	std::sort(m_stackSymbolNames.begin(), m_stackSymbolNames.end());
+	m_inputSymbolNames.assign(m_alphabet.begin(), m_alphabet.end());
+	std::sort(m_inputSymbolNames.begin(), m_inputSymbolNames.end());
+	m_inputSymbolNames.insert(m_inputSymbolNames.begin(), lambda);
+
+	m_inputSymbolIndexes.fill(kNoSymbol);
+	m_hasLongInputSymbols = false;
+	for (size_t i = 1; i < m_inputSymbolNames.size(); ++i) {
+		if (m_inputSymbolNames[i].size() == 1) {
+			m_inputSymbolIndexes[static_cast<unsigned char>(m_inputSymbolNames[i][0])] = static_cast<uint32_t>(i);
+		}
+		else {
+			m_hasLongInputSymbols = true;
+		}
+	}
+
+	auto inputIndex = [this, &lambda](const std::string& inputSymbol) -> uint32_t {
+		return inputSymbol == lambda ? 0 : GetInputSymbolIndex(std::string_view(inputSymbol));
+	};
+
+	const size_t offsetsCount = m_stateNames.size() * m_stackSymbolNames.size() * (m_inputSymbolNames.size() + 1);
+	m_image.reset();
+	m_ownedTransitionOffsets.assign(offsetsCount, 0);
+	m_ownedCompiledTransitions.clear();
+	m_ownedPushedSymbols.clear();
+	m_unusedTransitions = 0;
+	m_unusedPushedSymbols = 0;
+	m_pushers.clear();
+	m_pushersAreBuilt = false;
+
+	// First pass counts the results of every slot, second pass writes them at their final offsets. Nothing
+	// is counted at the first offset of a block, so it gets the end of the block before.
+	for (const auto& [state, secondMaps] : m_delta) {
+		const uint32_t stateIndex = GetStateIndex(state);
+		for (const auto& [stackSymbol, thirdMaps] : secondMaps) {
+			const uint32_t stackSymbolIndex = GetStackSymbolIndex(stackSymbol);
+			for (const auto& [inputSymbol, vectorOfPairs] : thirdMaps) {
+				const uint32_t inputSymbolIndex = inputIndex(inputSymbol);
+				if (stateIndex == kNoSymbol || stackSymbolIndex == kNoSymbol || inputSymbolIndex == kNoSymbol) {
+					throw "The transition uses a symbol that is not part of the automaton.";
+				}
+				m_ownedTransitionOffsets[mf_GetTransitionSlot(stateIndex, stackSymbolIndex, inputSymbolIndex) + 1] += static_cast<uint32_t>(vectorOfPairs.size());
+			}
+		}
+	}
+	for (size_t i = 1; i < m_ownedTransitionOffsets.size(); ++i) {
+		m_ownedTransitionOffsets[i] += m_ownedTransitionOffsets[i - 1];
+	}
+
+	std::vector<uint32_t> cursors(m_ownedTransitionOffsets);
+	m_ownedCompiledTransitions.resize(m_ownedTransitionOffsets.empty() ? 0 : m_ownedTransitionOffsets.back());
+	for (const auto& [state, secondMaps] : m_delta) {
+		const uint32_t stateIndex = GetStateIndex(state);
+		for (const auto& [stackSymbol, thirdMaps] : secondMaps) {
+			const uint32_t stackSymbolIndex = GetStackSymbolIndex(stackSymbol);
+			for (const auto& [inputSymbol, vectorOfPairs] : thirdMaps) {
+				const size_t slot = mf_GetTransitionSlot(stateIndex, stackSymbolIndex, inputIndex(inputSymbol));
+				for (const auto& [nextState, pushedString] : vectorOfPairs) {
+					CompiledTransition transition;
+					transition.state = GetStateIndex(nextState);
+					transition.pushBegin = static_cast<uint32_t>(m_ownedPushedSymbols.size());
+					if (transition.state == kNoSymbol) {
+						throw "The transition uses a symbol that is not part of the automaton.";
+					}
+					if (pushedString != lambda) {
+						mf_AppendPushedSymbols(pushedString);
+					}
+					transition.pushLength = static_cast<uint32_t>(m_ownedPushedSymbols.size()) - transition.pushBegin;
+					m_ownedCompiledTransitions[cursors[slot]++] = transition;
+				}
+			}
+		}
+	}
+
+	m_ownedIsFinalState.assign(m_stateNames.size(), 0);
+	for (const auto& state : m_finalStates) {
+		const uint32_t stateIndex = GetStateIndex(state);
+		if (stateIndex != kNoSymbol) {
+			m_ownedIsFinalState[stateIndex] = 1;
+		}
+	}
+	m_initialStateIndex = GetStateIndex(m_initialState);
+	m_stackStartSymbolIndex = GetStackSymbolIndex(m_stackStartSymbol);
+	std::vector<uint32_t> stackSymbols(m_stackSymbolNames.size());
+	std::iota(stackSymbols.begin(), stackSymbols.end(), 0);
+	m_ownedMinimumInputToPop.assign(m_stackSymbolNames.size(), kNoSymbol);
+	mf_ViewOwnedTables();
+	mf_ComputeMinimumInputToPop(stackSymbols);
+}
+
+void PushDownAutomaton::mf_AppendPushedSymbols(const std::string& pushedString)
+{
+	// Names longer than one character are written space separated; otherwise every character is a symbol,
+	// unless the whole string is the name of one symbol.
+	const uint32_t wholeSymbol = GetStackSymbolIndex(pushedString);
+	if (wholeSymbol != kNoSymbol) {
+		m_ownedPushedSymbols.push_back(wholeSymbol);
+		return;
+	}
+	const bool separated = pushedString.find(' ') != std::string::npos;
+	size_t begin = 0;
+	while (begin < pushedString.size()) {
+		size_t end = separated ? pushedString.find(' ', begin) : begin + 1;
+		if (end == std::string::npos) {
+			end = pushedString.size();
+		}
+		if (end > begin) {
+			const uint32_t pushedSymbol = GetStackSymbolIndex(pushedString.substr(begin, end - begin));
+			if (pushedSymbol == kNoSymbol) {
+				throw "The transition uses a symbol that is not part of the automaton.";
+			}
+			m_ownedPushedSymbols.push_back(pushedSymbol);
+		}
+		begin = separated ? end + 1 : end;
+	}
+}
+
+void PushDownAutomaton::mf_ComputeMinimumInputToPop(const std::vector<uint32_t>& stackSymbols)
+{
+	// Least number of input symbols consumed by any run that removes the symbol from the top of the stack,
+	// over all states. Relaxed until stable; symbols that can never be popped keep kNoSymbol. The given
+	// symbols must include every symbol that pushes one of them, so the others are already final.
+	// Runs on the owned tables, see mf_OwnTables.
+	std::vector<uint32_t>& minimumInputToPop = m_ownedMinimumInputToPop;
+	for (uint32_t stackSymbol : stackSymbols) {
+		minimumInputToPop[stackSymbol] = kNoSymbol;
+	}
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (uint32_t state = 0; state < m_stateNames.size(); ++state) {
+			for (uint32_t stackSymbol : stackSymbols) {
+				for (uint32_t inputSymbol = 0; inputSymbol < m_inputSymbolNames.size(); ++inputSymbol) {
+					for (auto it = TransitionsBegin(state, stackSymbol, inputSymbol), end = TransitionsEnd(state, stackSymbol, inputSymbol); it != end; ++it) {
+						uint64_t cost = inputSymbol != 0;
+						const uint32_t* pushed = PushedSymbols(*it);
+						for (uint32_t i = 0; i < it->pushLength && cost < kNoSymbol; ++i) {
+							cost += minimumInputToPop[pushed[i]];
+						}
+						if (cost < minimumInputToPop[stackSymbol]) {
+							minimumInputToPop[stackSymbol] = static_cast<uint32_t>(cost);
+							changed = true;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void PushDownAutomaton::mf_CompactTables()
+{
+	// The blocks are written back in slot order, each followed by nothing but the next one.
+	const size_t blockSize = m_inputSymbolNames.size() + 1;
+	std::vector<CompiledTransition> compiledTransitions;
+	std::vector<uint32_t> pushedSymbols;
+	compiledTransitions.reserve(m_ownedCompiledTransitions.size() - m_unusedTransitions);
+	pushedSymbols.reserve(m_ownedPushedSymbols.size() - m_unusedPushedSymbols);
+	for (size_t block = 0; block < m_ownedTransitionOffsets.size(); block += blockSize) {
+		const uint32_t begin = m_ownedTransitionOffsets[block];
+		const uint32_t end = m_ownedTransitionOffsets[block + blockSize - 1];
+		const uint32_t newBegin = static_cast<uint32_t>(compiledTransitions.size());
+		for (size_t i = 0; i < blockSize; ++i) {
+			m_ownedTransitionOffsets[block + i] += newBegin - begin; // modulo 2^32
+		}
+		for (uint32_t i = begin; i < end; ++i) {
+			CompiledTransition transition = m_ownedCompiledTransitions[i];
+			const uint32_t* pushed = m_ownedPushedSymbols.data() + transition.pushBegin;
+			transition.pushBegin = static_cast<uint32_t>(pushedSymbols.size());
+			pushedSymbols.insert(pushedSymbols.end(), pushed, pushed + transition.pushLength);
+			compiledTransitions.push_back(transition);
+		}
+	}
+	m_ownedCompiledTransitions = std::move(compiledTransitions);
+	m_ownedPushedSymbols = std::move(pushedSymbols);
+	m_unusedTransitions = 0;
+	m_unusedPushedSymbols = 0;
+}
+
+void PushDownAutomaton::mf_EnsurePushers()
+{
+	if (m_pushersAreBuilt) {
+		return;
+	}
+	const size_t blockSize = m_inputSymbolNames.size() + 1;
+	const CompiledTransition* transitions = m_ownedCompiledTransitions.data();
+	m_pushers.assign(m_stackSymbolNames.size(), {});
+	for (size_t block = 0; block < m_ownedTransitionOffsets.size(); block += blockSize) {
+		const uint32_t pusher = static_cast<uint32_t>(block / blockSize % m_stackSymbolNames.size());
+		mf_IndexPushers(pusher, transitions + m_ownedTransitionOffsets[block], transitions + m_ownedTransitionOffsets[block + blockSize - 1], true);
+	}
+	m_pushersAreBuilt = true;
+}
+
+void PushDownAutomaton::mf_IndexPushers(uint32_t pusher, const CompiledTransition* begin, const CompiledTransition* end, bool add)
+{
+	// One entry per pushed symbol; a removed entry is replaced by the last of its list, and one that is not
+	// there is skipped rather than trusted. Runs on the owned tables, see mf_OwnTables.
+	for (const CompiledTransition* transition = begin; transition != end; ++transition) {
+		const uint32_t* pushed = m_ownedPushedSymbols.data() + transition->pushBegin;
+		for (uint32_t i = 0; i < transition->pushLength; ++i) {
+			std::vector<uint32_t>& pushers = m_pushers[pushed[i]];
+			if (add) {
+				pushers.push_back(pusher);
+				continue;
+			}
+			auto it = std::find(pushers.begin(), pushers.end(), pusher);
+			if (it == pushers.end()) {
+				continue;
+			}
+			*it = pushers.back();
+			pushers.pop_back();
+		}
+	}
+}
+
+size_t PushDownAutomaton::mf_GetTransitionSlot(uint32_t state, uint32_t stackSymbol, uint32_t inputSymbol) const
+{
+	return (static_cast<size_t>(state) * m_stackSymbolNames.size() + stackSymbol) * (m_inputSymbolNames.size() + 1) + inputSymbol;
+}
+
+void PushDownAutomaton::mf_OwnTables()
+{
+	if (!m_image) {
+		return;
+	}
+	m_ownedTransitionOffsets.assign(m_transitionOffsets.begin(), m_transitionOffsets.end());
+	m_ownedCompiledTransitions.assign(m_compiledTransitions.begin(), m_compiledTransitions.end());
+	m_ownedPushedSymbols.assign(m_pushedSymbols.begin(), m_pushedSymbols.end());
+	m_ownedIsFinalState.assign(m_isFinalState.begin(), m_isFinalState.end());
+	m_ownedMinimumInputToPop.assign(m_minimumInputToPop.begin(), m_minimumInputToPop.end());
+	m_image.reset();
+	mf_ViewOwnedTables();
+}
+
+void PushDownAutomaton::mf_ViewOwnedTables()
+{
+	m_transitionOffsets = m_ownedTransitionOffsets;
+	m_compiledTransitions = m_ownedCompiledTransitions;
+	m_pushedSymbols = m_ownedPushedSymbols;
+	m_isFinalState = m_ownedIsFinalState;
+	m_minimumInputToPop = m_ownedMinimumInputToPop;
+}
+
+void PushDownAutomaton::mf_EnsureDelta() const
+{
+	if (m_deltaIsBuilt.load(std::memory_order_acquire)) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(m_deltaMutex);
+	if (!m_deltaIsBuilt.load(std::memory_order_relaxed)) {
+		mf_RebuildDelta();
+		m_deltaIsBuilt.store(true, std::memory_order_release);
+	}
+}
+
+void PushDownAutomaton::mf_RebuildDelta() const
+{
+	m_states.clear();
+	m_states.insert(m_stateNames.begin(), m_stateNames.end());
+	m_stackAlphabet.clear();
+	m_stackAlphabet.insert(m_stackSymbolNames.begin(), m_stackSymbolNames.end());
+	m_alphabet.clear();
+	m_alphabet.insert(m_inputSymbolNames.begin() + 1, m_inputSymbolNames.end());
+	m_initialState = m_initialStateIndex != kNoSymbol ? m_stateNames[m_initialStateIndex] : std::string();
+	m_stackStartSymbol = m_stackStartSymbolIndex != kNoSymbol ? m_stackSymbolNames[m_stackStartSymbolIndex] : std::string();
+	m_finalStates.clear();
+	for (uint32_t state = 0; state < m_stateNames.size(); ++state) {
+		if (m_isFinalState[state]) {
+			m_finalStates.insert(m_stateNames[state]);
+		}
+	}
+
+	// Pushed symbols are written back the way the constructor reads them: glued together, or space
+	// separated once a name is longer than one character.
+	bool separated = false;
+	for (const std::string& name : m_stackSymbolNames) {
+		separated = separated || name.size() != 1;
+	}
+	m_delta.clear();
+	for (uint32_t state = 0; state < m_stateNames.size(); ++state) {
+		for (uint32_t stackSymbol = 0; stackSymbol < m_stackSymbolNames.size(); ++stackSymbol) {
+			for (uint32_t inputSymbol = 0; inputSymbol < m_inputSymbolNames.size(); ++inputSymbol) {
+				const CompiledTransition* begin = TransitionsBegin(state, stackSymbol, inputSymbol);
+				const CompiledTransition* end = TransitionsEnd(state, stackSymbol, inputSymbol);
+				if (begin == end) {
+					continue;
+				}
+				DeltaResult& result = m_delta[m_stateNames[state]][m_stackSymbolNames[stackSymbol]][m_inputSymbolNames[inputSymbol]];
+				for (const CompiledTransition* transition = begin; transition != end; ++transition) {
+					std::string pushedString;
+					for (uint32_t i = 0; i < transition->pushLength; ++i) {
+						if (separated && i) {
+							pushedString += ' ';
+						}
+						pushedString += m_stackSymbolNames[PushedSymbols(*transition)[i]];
+					}
+					result.emplace_back(m_stateNames[transition->state], pushedString.empty() ? std::string(1, kLambda) : pushedString);
+				}
+			}
+		}
+	}
+}
+
 std::ostream& operator<<(std::ostream& out, const PushDownAutomaton& pushDownAutomaton)
 {
+	pushDownAutomaton.mf_EnsureDelta();
 	const auto& states = pushDownAutomaton.m_states;
 	const auto& alphabet = pushDownAutomaton.m_alphabet;
 	const auto& stackAlphabet = pushDownAutomaton.m_stackAlphabet;
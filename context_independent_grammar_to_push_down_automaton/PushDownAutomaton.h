@@ -2,36 +2,215 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <span>
+#include <memory>
+#include <atomic>
+#include <mutex>
+
+#include "Grammar.h"
+#include "StampedHashMap.h"
+
+class MappedFile;
 
 class PushDownAutomaton
 {
+public:
+	enum class AcceptanceMode : uint8_t
+	{
+		EmptyStack,
+		FinalStates
+	};
+
 public:
 	static const char kLambda = '_';
+	static constexpr uint32_t kNoSymbol = UINT32_MAX;
 
 public:
 	using StateStackSymbolPair = std::pair<std::string, std::string>;
 	using DeltaResult = std::vector<StateStackSymbolPair>;
 	using DeltaFunctionDefiniton = std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, DeltaResult>>>;
 
+public:
+	// One element of a compiled DeltaResult: the next state and the symbols pushed in place of the stack top,
+	// stored as [pushBegin, pushBegin + pushLength) in m_pushedSymbols with the new top first.
+	struct CompiledTransition
+	{
+		uint32_t state;
+		uint32_t pushBegin;
+		uint32_t pushLength;
+	};
+
+public:
+	// Scratch memory of Accepts, a graph-structured stack. A node is a stack symbol on the top in a state at
+	// an input position and is expanded once, however many stacks have it there. The (state, position) pairs
+	// it can be popped at are recorded on it and handed to every return waiting on it, where a return is a
+	// transition of the node below with how many of its pushed symbols are popped already. Reusing one
+	// context across calls keeps its buffers allocated.
+	class AcceptanceContext
+	{
+	private:
+		friend class PushDownAutomaton;
+
+	private:
+		struct Node
+		{
+			uint32_t symbol;
+			uint32_t configuration; // position * states count + state
+			uint32_t firstReturn; // lists in m_links
+			uint32_t firstPop;
+		};
+
+		struct Return
+		{
+			uint32_t transition; // kNoSymbol once the whole stack is popped
+			uint32_t popped;
+			uint32_t node; // the node the transition replaced, popped with the last pushed symbol
+		};
+
+		struct Link
+		{
+			uint32_t value;
+			uint32_t next;
+		};
+
+		struct Step
+		{
+			uint32_t returnIndex;
+			uint32_t configuration;
+		};
+
+		struct Match
+		{
+			uint32_t inputSymbol;
+			uint32_t length; // in characters
+		};
+
+	private:
+		std::vector<uint32_t> m_input;
+		std::vector<uint32_t> m_matchOffsets; // per character of a word split by names, its matches in m_matches; empty when m_input is read
+		std::vector<Match> m_matches;
+		std::vector<Node> m_nodes;
+		std::vector<Return> m_returns;
+		std::vector<Link> m_links;
+		std::vector<Step> m_steps;
+		StampedHashMap m_nodeIndexes;
+		StampedHashMap m_seenReturns; // (node, return)
+		StampedHashMap m_seenPops; // (node, configuration)
+	};
+
 public:
 	PushDownAutomaton();
+	PushDownAutomaton(const Grammar& grammar);
 	PushDownAutomaton(const PushDownAutomaton& pushDownAutomaton);
+	PushDownAutomaton(PushDownAutomaton&& pushDownAutomaton) noexcept;
 
 public:
 	PushDownAutomaton& operator =(const PushDownAutomaton& pushDownAutomaton);
+	PushDownAutomaton& operator =(PushDownAutomaton&& pushDownAutomaton) noexcept;
 	bool operator ==(const PushDownAutomaton& pushDownAutomaton);
 	friend std::ostream& operator <<(std::ostream& out, const PushDownAutomaton& pushDownAutomaton);
 
 public:
+	bool Accepts(std::string_view word, AcceptanceMode mode = AcceptanceMode::EmptyStack) const;
+	bool Accepts(std::string_view word, AcceptanceContext& context, AcceptanceMode mode = AcceptanceMode::EmptyStack) const;
+	bool Accepts(std::span<const uint32_t> inputSymbols, AcceptanceMode mode = AcceptanceMode::EmptyStack) const; // input symbol indexes, see Tokenize
+	bool Accepts(std::span<const uint32_t> inputSymbols, AcceptanceContext& context, AcceptanceMode mode = AcceptanceMode::EmptyStack) const;
+	std::vector<uint64_t> AcceptsAll(std::span<const std::string> words, AcceptanceMode mode = AcceptanceMode::EmptyStack) const; // bit i of the result is set if words[i] is accepted
+	std::vector<uint64_t> AcceptsAll(std::span<const std::string_view> words, AcceptanceMode mode = AcceptanceMode::EmptyStack) const;
 
+public:
+	void SaveBinary(std::ostream& out) const; // the compiled tables, see BinaryFormat
+	void SaveBinary(const std::string& path) const;
+	void LoadBinary(std::span<const uint8_t> bytes);
+	void LoadBinary(const std::string& path); // mapped; the tables are read in place until they are changed
+
+public:
+	// Replaces every transition of (state, stackSymbol), patching the compiled tables in place: the new
+	// transitions are appended and the old ones left as a hole until enough of them pile up. All the names
+	// must already be part of the automaton.
+	void ReplaceTransitions(const std::string& state, const std::string& stackSymbol, std::unordered_map<std::string, DeltaResult> results);
+
+public:
+	uint32_t GetStateIndex(const std::string& state) const;
+	uint32_t GetStackSymbolIndex(const std::string& stackSymbol) const;
+	uint32_t GetInputSymbolIndex(char inputSymbol) const;
+	uint32_t GetInputSymbolIndex(std::string_view inputSymbol) const;
+	bool Tokenize(std::string_view word, std::vector<uint32_t>& inputSymbols) const; // one split, by longest match over the input symbol names; Accepts tries them all
+	const CompiledTransition* TransitionsBegin(uint32_t state, uint32_t stackSymbol, uint32_t inputSymbol) const;
+	const CompiledTransition* TransitionsEnd(uint32_t state, uint32_t stackSymbol, uint32_t inputSymbol) const;
+	const uint32_t* PushedSymbols(const CompiledTransition& transition) const;
 
 private:
-	std::unordered_set<std::string> m_states;
-	std::unordered_set<std::string> m_alphabet;
-	std::unordered_set<std::string> m_stackAlphabet;
-	std::string m_initialState;
-	std::string m_stackStartSymbol;
-	std::unordered_set<std::string> m_finalStates;
-	DeltaFunctionDefiniton m_delta;
-};
+	void mf_CompileTransitions();
+	size_t mf_GetTransitionSlot(uint32_t state, uint32_t stackSymbol, uint32_t inputSymbol) const;
+	void mf_AppendPushedSymbols(const std::string& pushedString);
+	void mf_ComputeMinimumInputToPop(const std::vector<uint32_t>& stackSymbols); // the others are kept
+	void mf_CompactTables(); // drops the holes ReplaceTransitions left behind
+	void mf_EnsurePushers(); // builds m_pushers before the first edit, from the owned tables
+	void mf_IndexPushers(uint32_t pusher, const CompiledTransition* begin, const CompiledTransition* end, bool add);
+	void mf_LoadBinary(std::span<const uint8_t> bytes, std::shared_ptr<const MappedFile> image);
+	void mf_OwnTables(); // before a change, copies the tables out of a mapped image
+	void mf_ViewOwnedTables(); // after a change, points the table spans at the owned vectors
+	void mf_EnsureDelta() const; // builds the string view on first use after LoadBinary, once even when several threads ask
+	void mf_RebuildDelta() const; // the string view of the automaton, from the compiled tables
+	void mf_MatchInputSymbols(std::string_view word, AcceptanceContext& context) const; // every input symbol name at every position
+	template <typename Visit>
+	void mf_ForEachInputSymbolAt(std::string_view word, size_t position, Visit visit) const; // visit(inputSymbol, length), shortest first
+	bool mf_AcceptsInput(AcceptanceContext& context, AcceptanceMode mode) const; // runs on context.m_input, or on the matches
+	template <typename Word>
+	std::vector<uint64_t> mf_AcceptsAll(std::span<const Word> words, AcceptanceMode mode) const;
+
+private:
+	friend class GrammarEditor;
+
+private:
+	// The string view of the automaton. A loaded automaton has only its compiled tables, so the string view
+	// is built from them the first time it is asked for.
+	mutable std::unordered_set<std::string> m_states;
+	mutable std::unordered_set<std::string> m_alphabet;
+	mutable std::unordered_set<std::string> m_stackAlphabet;
+	mutable std::string m_initialState;
+	mutable std::string m_stackStartSymbol;
+	mutable std::unordered_set<std::string> m_finalStates;
+	mutable DeltaFunctionDefiniton m_delta;
+	mutable std::atomic<bool> m_deltaIsBuilt;
+	mutable std::mutex m_deltaMutex;
 
+private:
+	// Dense view of m_delta. States, stack symbols and input symbols get consecutive indexes; the input
+	// index 0 stands for lambda. Every (state, stackSymbol) has inputSymbolsCount + 1 offsets, and the
+	// results of the slot (state, stackSymbol, inputSymbol) are
+	// m_compiledTransitions[m_transitionOffsets[slot], m_transitionOffsets[slot + 1]). The transitions of
+	// one (state, stackSymbol) are consecutive, but the blocks need not be in order nor without gaps.
+	std::vector<std::string> m_stateNames;
+	std::vector<std::string> m_stackSymbolNames;
+	std::vector<std::string> m_inputSymbolNames;
+	std::array<uint32_t, 256> m_inputSymbolIndexes;
+	bool m_hasLongInputSymbols; // words are then split in every way by the names instead of m_inputSymbolIndexes
+	std::span<const uint32_t> m_transitionOffsets;
+	std::span<const CompiledTransition> m_compiledTransitions;
+	std::span<const uint32_t> m_pushedSymbols;
+	size_t m_unusedTransitions; // left behind in m_compiledTransitions by ReplaceTransitions
+	size_t m_unusedPushedSymbols; // left behind in m_pushedSymbols by ReplaceTransitions
+	std::span<const uint8_t> m_isFinalState;
+	std::span<const uint32_t> m_minimumInputToPop;
+	uint32_t m_initialStateIndex;
+	uint32_t m_stackStartSymbolIndex;
+	std::vector<std::vector<uint32_t>> m_pushers; // per stack symbol, the stack symbols with a transition pushing it, once per push
+	bool m_pushersAreBuilt;
+
+private:
+	// The table spans above point either into these vectors or into m_image, the mapped file the automaton
+	// was loaded from, which its copies share.
+	std::shared_ptr<const MappedFile> m_image;
+	std::vector<uint32_t> m_ownedTransitionOffsets;
+	std::vector<CompiledTransition> m_ownedCompiledTransitions;
+	std::vector<uint32_t> m_ownedPushedSymbols;
+	std::vector<uint8_t> m_ownedIsFinalState;
+	std::vector<uint32_t> m_ownedMinimumInputToPop;
+};
@@ -0,0 +1,72 @@
+#include "RandomEngine.h"
+#include <bit>
+#include <random>
+
+RandomEngine::RandomEngine()
+	: RandomEngine((static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}())
+{
+	/* EMPTY */
+}
+RandomEngine::RandomEngine(uint64_t seed)
+	: m_seed(seed)
+{
+	// The state is filled through splitmix64, so any seed (including 0) gives a non-zero state.
+	uint64_t splitMixState = seed;
+	for (uint64_t& word : m_state) {
+		word = mf_SplitMix(splitMixState);
+	}
+}
+
+RandomEngine::result_type RandomEngine::operator()()
+{
+	const uint64_t result = std::rotl(m_state[1] * 5, 7) * 9;
+	const uint64_t t = m_state[1] << 17;
+	m_state[2] ^= m_state[0];
+	m_state[3] ^= m_state[1];
+	m_state[1] ^= m_state[2];
+	m_state[0] ^= m_state[3];
+	m_state[2] ^= t;
+	m_state[3] = std::rotl(m_state[3], 45);
+	return result;
+}
+
+uint64_t RandomEngine::GetSeed() const
+{
+	return m_seed;
+}
+
+RandomEngine RandomEngine::GetStream(uint64_t streamIndex) const
+{
+	uint64_t mixed = m_seed ^ 0x6a09e667f3bcc909ULL;
+	mixed = mf_SplitMix(mixed) ^ streamIndex;
+	return RandomEngine(mf_SplitMix(mixed));
+}
+
+uint64_t RandomEngine::NextBelow(uint64_t bound)
+{
+	// Draws below the threshold are rejected so that every residue is equally likely.
+	const uint64_t threshold = (0 - bound) % bound;
+	uint64_t value = (*this)();
+	while (value < threshold) {
+		value = (*this)();
+	}
+	return value % bound;
+}
+
+size_t RandomEngine::NextInRange(size_t leftBound, size_t rightBound)
+{
+	return leftBound + static_cast<size_t>(NextBelow(static_cast<uint64_t>(rightBound - leftBound) + 1));
+}
+
+double RandomEngine::NextDouble()
+{
+	return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+}
+
+uint64_t RandomEngine::mf_SplitMix(uint64_t& state)
+{
+	uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// xoshiro256** generator. A fixed seed gives the same numbers on every platform, since the bounded draws
+// do not go through std::uniform_int_distribution (whose algorithm is left to the library). GetStream(i)
+// derives an independent engine from the seed and i alone, so work split across any number of threads
+// can give item i the stream i and stay reproducible.
+class RandomEngine
+{
+public:
+	using result_type = uint64_t;
+
+public:
+	RandomEngine(); // seeded from std::random_device
+	RandomEngine(uint64_t seed);
+
+public:
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+	result_type operator()();
+
+public:
+	uint64_t GetSeed() const;
+	RandomEngine GetStream(uint64_t streamIndex) const;
+
+public:
+	uint64_t NextBelow(uint64_t bound); // uniform in [0, bound), bound > 0
+	size_t NextInRange(size_t leftBound, size_t rightBound); // uniform in [leftBound, rightBound]
+	double NextDouble(); // uniform in [0, 1)
+
+private:
+	static uint64_t mf_SplitMix(uint64_t& state);
+
+private:
+	uint64_t m_seed;
+	std::array<uint64_t, 4> m_state;
+};
@@ -0,0 +1,156 @@
+#include "SententialForm.h"
+#include <algorithm>
+
+SententialForm::SententialForm(const std::vector<uint32_t>& weights, const std::vector<bool>& isNonterminal, Symbol lambda)
+	: m_first(kNoNode)
+	, m_occurrences(weights.size())
+	, m_weights(weights)
+	, m_tree(weights.size() + 1, 0)
+	, m_isNonterminal(isNonterminal)
+	, m_lambda(lambda)
+{
+	m_isNonterminal.resize(weights.size(), false);
+}
+
+void SententialForm::Reset(Symbol start)
+{
+	m_nodes.clear();
+	m_freeNodes.clear();
+	for (auto& occurrences : m_occurrences) {
+		occurrences.clear();
+	}
+	std::fill(m_tree.begin(), m_tree.end(), 0);
+	m_first = mf_AddNode(start, kNoNode, kNoNode);
+}
+
+void SententialForm::Replace(uint32_t node, SymbolStringView right)
+{
+	const uint32_t previous = m_nodes[node].previous;
+	const uint32_t next = m_nodes[node].next;
+	mf_RemoveOccurrence(node);
+	m_freeNodes.push_back(node);
+
+	uint32_t last = previous;
+	for (Symbol symbol : right) {
+		if (symbol == m_lambda) {
+			continue;
+		}
+		const uint32_t added = mf_AddNode(symbol, last, next);
+		if (last == kNoNode) {
+			m_first = added;
+		}
+		else {
+			m_nodes[last].next = added;
+		}
+		last = added;
+	}
+	if (last == kNoNode) {
+		m_first = next;
+	}
+	else {
+		m_nodes[last].next = next;
+	}
+	if (next != kNoNode) {
+		m_nodes[next].previous = last;
+	}
+}
+
+bool SententialForm::HasWeightedNonterminals() const
+{
+	return GetTotalWeight() != 0;
+}
+
+uint64_t SententialForm::GetTotalWeight() const
+{
+	uint64_t total = 0;
+	for (size_t i = m_weights.size(); i > 0; i -= i & (~i + 1)) {
+		total += m_tree[i];
+	}
+	return total;
+}
+
+SententialForm::Symbol SententialForm::FindNonterminal(uint64_t weight) const
+{
+	size_t position = 0;
+	size_t step = 1;
+	while (step * 2 <= m_weights.size()) {
+		step *= 2;
+	}
+	for (; step > 0; step /= 2) {
+		if (position + step <= m_weights.size() && m_tree[position + step] <= weight) {
+			position += step;
+			weight -= m_tree[position];
+		}
+	}
+	return static_cast<Symbol>(position);
+}
+
+size_t SententialForm::GetOccurrencesCount(Symbol nonterminal) const
+{
+	return m_occurrences[nonterminal].size();
+}
+
+uint32_t SententialForm::GetOccurrence(Symbol nonterminal, size_t index) const
+{
+	return m_occurrences[nonterminal][index];
+}
+
+std::string SententialForm::ToString(const SymbolTable& symbolTable) const
+{
+	std::string result;
+	AppendTo(result, symbolTable);
+	return result;
+}
+
+void SententialForm::AppendTo(std::string& string, const SymbolTable& symbolTable) const
+{
+	for (uint32_t node = m_first; node != kNoNode; node = m_nodes[node].next) {
+		string += symbolTable.GetName(m_nodes[node].symbol);
+	}
+}
+
+uint32_t SententialForm::mf_AddNode(Symbol symbol, uint32_t previous, uint32_t next)
+{
+	uint32_t node;
+	if (!m_freeNodes.empty()) {
+		node = m_freeNodes.back();
+		m_freeNodes.pop_back();
+	}
+	else {
+		node = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.emplace_back();
+	}
+	m_nodes[node] = { symbol, previous, next, kNoNode };
+	if (symbol < m_isNonterminal.size() && m_isNonterminal[symbol]) {
+		auto& occurrences = m_occurrences[symbol];
+		m_nodes[node].occurrence = static_cast<uint32_t>(occurrences.size());
+		occurrences.push_back(node);
+		if (occurrences.size() == 1) {
+			mf_AddToTree(symbol, m_weights[symbol]);
+		}
+	}
+	return node;
+}
+
+void SententialForm::mf_RemoveOccurrence(uint32_t node)
+{
+	const uint32_t occurrence = m_nodes[node].occurrence;
+	if (occurrence == kNoNode) {
+		return;
+	}
+	const Symbol symbol = m_nodes[node].symbol;
+	auto& occurrences = m_occurrences[symbol];
+	occurrences[occurrence] = occurrences.back();
+	m_nodes[occurrences[occurrence]].occurrence = occurrence;
+	occurrences.pop_back();
+	if (occurrences.empty()) {
+		mf_AddToTree(symbol, -static_cast<int64_t>(m_weights[symbol]));
+	}
+}
+
+void SententialForm::mf_AddToTree(Symbol symbol, int64_t delta)
+{
+	for (size_t i = symbol + 1; i < m_tree.size(); i += i & (~i + 1)) {
+		m_tree[i] += delta;
+	}
+}
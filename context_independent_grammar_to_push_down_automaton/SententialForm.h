@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SymbolTable.h"
+
+// Sentential form of a context independent derivation, kept as a doubly linked list of symbol nodes in one
+// pool. Every nonterminal has the list of its occurrences and a weight (the number of its productions);
+// a Fenwick tree over the weights of the nonterminals that occur lets a random rewrite be chosen with the
+// probability the whole-string generator gives it. Rewriting one occurrence costs O(|right part| + log V),
+// whatever the length of the form.
+class SententialForm
+{
+public:
+	using Symbol = SymbolTable::Symbol;
+	using SymbolString = SymbolTable::SymbolString;
+	using SymbolStringView = SymbolTable::SymbolStringView;
+
+public:
+	static constexpr uint32_t kNoNode = UINT32_MAX;
+
+public:
+	SententialForm(const std::vector<uint32_t>& weights, const std::vector<bool>& isNonterminal, Symbol lambda);
+
+public:
+	void Reset(Symbol start);
+	void Replace(uint32_t node, SymbolStringView right);
+
+public:
+	bool HasWeightedNonterminals() const;
+	uint64_t GetTotalWeight() const;
+	Symbol FindNonterminal(uint64_t weight) const; // the nonterminal whose weight range contains weight
+	size_t GetOccurrencesCount(Symbol nonterminal) const;
+	uint32_t GetOccurrence(Symbol nonterminal, size_t index) const;
+
+public:
+	std::string ToString(const SymbolTable& symbolTable) const;
+	void AppendTo(std::string& string, const SymbolTable& symbolTable) const;
+
+private:
+	struct Node
+	{
+		Symbol symbol;
+		uint32_t previous;
+		uint32_t next;
+		uint32_t occurrence; // index in the occurrence list of its nonterminal
+	};
+
+private:
+	uint32_t mf_AddNode(Symbol symbol, uint32_t previous, uint32_t next);
+	void mf_RemoveOccurrence(uint32_t node);
+	void mf_AddToTree(Symbol symbol, int64_t delta);
+
+private:
+	std::vector<Node> m_nodes;
+	std::vector<uint32_t> m_freeNodes;
+	uint32_t m_first;
+	std::vector<std::vector<uint32_t>> m_occurrences;
+	std::vector<uint32_t> m_weights;
+	std::vector<uint64_t> m_tree; // Fenwick tree, 1-based, over the weights of the occurring nonterminals
+	std::vector<bool> m_isNonterminal;
+	Symbol m_lambda;
+};
@@ -1,19 +1,19 @@
-//#include "Grammar.h"
+#include "Grammar.h"
 #include "PushDownAutomaton.h"
 #include <iostream>
 
 int main()
 {
-	/*Grammar g;
+	Grammar g;
 
 	std::ifstream in("grammar_input.txt");
 	g.ReadFile(in);
 	g.SimplifyGrammar();
 	g.MakeItChomsky();
-	g.MakeItGreibach();*/
+	g.MakeItGreibach();
 
-	PushDownAutomaton pda;
+	PushDownAutomaton pda(g);
 	std::cout << pda;
 
 	return 0;
-}
\ No newline at end of file
+}
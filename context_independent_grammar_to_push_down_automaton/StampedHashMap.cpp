@@ -0,0 +1,83 @@
+#include "StampedHashMap.h"
+
+StampedHashMap::StampedHashMap()
+	: m_buckets(16, Bucket{ 0, 0, 0 })
+	, m_stamp(1)
+	, m_size(0)
+{
+	/* EMPTY */
+}
+
+uint32_t StampedHashMap::Find(uint64_t key) const
+{
+	const size_t mask = m_buckets.size() - 1;
+	for (size_t i = mf_GetBucketIndex(key); m_buckets[i].stamp == m_stamp; i = (i + 1) & mask) {
+		if (m_buckets[i].key == key) {
+			return m_buckets[i].value;
+		}
+	}
+	return kNotFound;
+}
+
+uint32_t StampedHashMap::Insert(uint64_t key, uint32_t value)
+{
+	if ((m_size + 1) * 2 > m_buckets.size()) {
+		mf_Grow();
+	}
+	const size_t mask = m_buckets.size() - 1;
+	size_t i = mf_GetBucketIndex(key);
+	for (; m_buckets[i].stamp == m_stamp; i = (i + 1) & mask) {
+		if (m_buckets[i].key == key) {
+			return m_buckets[i].value;
+		}
+	}
+	m_buckets[i] = Bucket{ key, value, m_stamp };
+	++m_size;
+	return kNotFound;
+}
+
+void StampedHashMap::Clear()
+{
+	m_size = 0;
+	if (++m_stamp == 0) {
+		for (Bucket& bucket : m_buckets) {
+			bucket.stamp = 0;
+		}
+		m_stamp = 1;
+	}
+}
+
+size_t StampedHashMap::Size() const
+{
+	return m_size;
+}
+
+void StampedHashMap::mf_Grow()
+{
+	std::vector<Bucket> oldBuckets(m_buckets.size() * 2, Bucket{ 0, 0, 0 });
+	oldBuckets.swap(m_buckets);
+	const uint32_t oldStamp = m_stamp;
+	const size_t mask = m_buckets.size() - 1;
+
+	m_stamp = 1;
+	for (const Bucket& bucket : oldBuckets) {
+		if (bucket.stamp != oldStamp) {
+			continue;
+		}
+		size_t i = mf_GetBucketIndex(bucket.key);
+		while (m_buckets[i].stamp == m_stamp) {
+			i = (i + 1) & mask;
+		}
+		m_buckets[i] = Bucket{ bucket.key, bucket.value, m_stamp };
+	}
+}
+
+size_t StampedHashMap::mf_GetBucketIndex(uint64_t key) const
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return static_cast<size_t>(key) & (m_buckets.size() - 1);
+}
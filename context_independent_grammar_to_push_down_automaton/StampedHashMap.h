@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Open-addressing map from 64-bit keys to 32-bit values. Clear() only advances a stamp, so a map that is
+// reused for many short searches keeps its buckets instead of freeing and reallocating them.
+class StampedHashMap
+{
+public:
+	static constexpr uint32_t kNotFound = UINT32_MAX;
+
+public:
+	StampedHashMap();
+
+public:
+	uint32_t Find(uint64_t key) const;
+	uint32_t Insert(uint64_t key, uint32_t value); // returns the value already stored for key, or kNotFound if value was inserted
+	void Clear();
+	size_t Size() const;
+
+private:
+	struct Bucket
+	{
+		uint64_t key;
+		uint32_t value;
+		uint32_t stamp;
+	};
+
+private:
+	void mf_Grow();
+	size_t mf_GetBucketIndex(uint64_t key) const;
+
+private:
+	std::vector<Bucket> m_buckets;
+	uint32_t m_stamp;
+	size_t m_size;
+};
@@ -0,0 +1,64 @@
+#include "SymbolTable.h"
+
+SymbolTable::SymbolTable()
+	: m_names(std::make_shared<Names>())
+{
+	/* EMPTY */
+}
+
+bool SymbolTable::operator==(const SymbolTable& symbolTable) const
+{
+	return m_names == symbolTable.m_names || m_names->names == symbolTable.m_names->names;
+}
+
+SymbolTable::Symbol SymbolTable::Intern(std::string_view name)
+{
+	auto it = m_names->symbols.find(name);
+	if (it != m_names->symbols.end()) {
+		return it->second;
+	}
+	if (m_names.use_count() > 1) {
+		m_names = std::make_shared<Names>(*m_names);
+	}
+	const Symbol symbol = static_cast<Symbol>(m_names->names.size());
+	m_names->names.emplace_back(name);
+	m_names->symbols.emplace(std::string(name), symbol);
+	return symbol;
+}
+
+SymbolTable::Symbol SymbolTable::Find(std::string_view name) const
+{
+	auto it = m_names->symbols.find(name);
+	return it != m_names->symbols.end() ? it->second : kNoSymbol;
+}
+
+const std::string& SymbolTable::GetName(Symbol symbol) const
+{
+	return m_names->names[symbol];
+}
+
+size_t SymbolTable::Size() const
+{
+	return m_names->names.size();
+}
+
+std::string SymbolTable::ToString(SymbolStringView symbols) const
+{
+	bool separate = false;
+	for (Symbol symbol : symbols) {
+		separate = separate || m_names->names[symbol].size() != 1;
+	}
+	std::string result;
+	for (size_t i = 0; i < symbols.size(); ++i) {
+		if (separate && i) {
+			result.push_back(' ');
+		}
+		result += m_names->names[symbols[i]];
+	}
+	return result;
+}
+
+size_t SymbolTable::NameHash::operator()(std::string_view name) const
+{
+	return std::hash<std::string_view>()(name);
+}
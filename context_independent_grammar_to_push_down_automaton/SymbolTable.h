@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Interns symbol names into dense ids (0, 1, 2, ...), so the rest of the code compares and indexes
+// symbols as integers and only looks names up for input and output. A sequence of symbols is a
+// SymbolString; char32_t is used only to get std::basic_string (small buffer, substr, hashing) over ids.
+// Copies share the names until one of them interns a new name, so copying a grammar does not copy them.
+class SymbolTable
+{
+public:
+	using Symbol = char32_t;
+	using SymbolString = std::u32string;
+	using SymbolStringView = std::u32string_view;
+
+public:
+	static constexpr Symbol kNoSymbol = UINT32_MAX;
+
+public:
+	SymbolTable();
+	SymbolTable(const SymbolTable& symbolTable) = default; // moves copy too, so no table is ever left empty
+
+public:
+	SymbolTable& operator =(const SymbolTable& symbolTable) = default;
+	bool operator ==(const SymbolTable& symbolTable) const;
+
+public:
+	Symbol Intern(std::string_view name);
+	Symbol Find(std::string_view name) const;
+	const std::string& GetName(Symbol symbol) const;
+	size_t Size() const;
+
+public:
+	std::string ToString(SymbolStringView symbols) const; // names glued together, space separated once a name is longer than one character
+
+private:
+	// Lets the symbols be searched with a string_view, without building a std::string for every lookup.
+	struct NameHash
+	{
+		using is_transparent = void;
+		size_t operator ()(std::string_view name) const;
+	};
+
+private:
+	struct Names
+	{
+		std::vector<std::string> names;
+		std::unordered_map<std::string, Symbol, NameHash, std::equal_to<>> symbols;
+	};
+
+private:
+	std::shared_ptr<Names> m_names; // shared with the copies
+};
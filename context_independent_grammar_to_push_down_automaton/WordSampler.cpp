@@ -0,0 +1,198 @@
+#include "WordSampler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+WordSampler::WordSampler(const Grammar& chomskyGrammar, size_t maxLength)
+	: m_nonterminalsCount(chomskyGrammar.GetNonterminalSymbols().size())
+	, m_acceptsEmptyWord(false)
+	, m_maxLength(maxLength)
+{
+	const SymbolTable& symbolTable = chomskyGrammar.GetSymbolTable();
+	const auto& nonterminals = chomskyGrammar.GetNonterminalSymbols();
+	m_nonterminalIndexes.assign(symbolTable.Size(), kNoSymbol);
+	for (size_t i = 0; i < nonterminals.size(); ++i) {
+		m_nonterminalIndexes[nonterminals[i]] = static_cast<uint32_t>(i);
+	}
+	std::vector<bool> isTerminal(symbolTable.Size(), false);
+	for (Grammar::Symbol symbol : chomskyGrammar.GetTerminalSymbols()) {
+		isTerminal[symbol] = true;
+	}
+	m_startIndex = mf_GetNonterminalIndex(chomskyGrammar.GetStartSymbol());
+	m_terminalRules.resize(m_nonterminalsCount);
+	m_binaryRules.resize(m_nonterminalsCount);
+
+	for (const auto& [left, right] : chomskyGrammar.GetProductions()) {
+		const uint32_t leftIndex = left.size() == 1 ? mf_GetNonterminalIndex(left[0]) : kNoSymbol;
+		if (leftIndex == kNoSymbol) {
+			throw "The grammar is not in Chomsky normal form.";
+		}
+		if (right.size() == 1 && right[0] == Grammar::kLambdaSymbol) {
+			if (leftIndex != m_startIndex) {
+				throw "The grammar is not in Chomsky normal form.";
+			}
+			m_acceptsEmptyWord = true;
+			continue;
+		}
+		if (right.size() == 1 && isTerminal[right[0]]) {
+			m_terminalRules[leftIndex].push_back(symbolTable.GetName(right[0]));
+			continue;
+		}
+		const uint32_t firstIndex = right.size() == 2 ? mf_GetNonterminalIndex(right[0]) : kNoSymbol;
+		const uint32_t secondIndex = right.size() == 2 ? mf_GetNonterminalIndex(right[1]) : kNoSymbol;
+		if (firstIndex == kNoSymbol || secondIndex == kNoSymbol) {
+			throw "The grammar is not in Chomsky normal form.";
+		}
+		m_binaryRules[leftIndex].push_back({ firstIndex, secondIndex });
+	}
+
+	mf_CountTrees();
+}
+
+size_t WordSampler::GetMaxLength() const
+{
+	return m_maxLength;
+}
+
+double WordSampler::GetLogCount(size_t length) const
+{
+	if (m_startIndex == kNoSymbol || length > m_maxLength) {
+		return -std::numeric_limits<double>::infinity();
+	}
+	if (length == 0) {
+		return m_acceptsEmptyWord ? 0.0 : -std::numeric_limits<double>::infinity();
+	}
+	return mf_GetLogCount(m_startIndex, length);
+}
+
+bool WordSampler::HasWords(size_t length) const
+{
+	return GetLogCount(length) != -std::numeric_limits<double>::infinity();
+}
+
+std::string WordSampler::SampleTreeUniform(size_t length, RandomEngine& engine) const
+{
+	if (!HasWords(length)) {
+		throw "The grammar generates no word of this length.";
+	}
+
+	// Depth first, left child on top of the stack, so the terminals come out from left to right.
+	std::string word;
+	std::vector<std::pair<uint32_t, size_t>> pending;
+	if (length) {
+		pending.emplace_back(m_startIndex, length);
+	}
+	while (!pending.empty()) {
+		const auto [nonterminal, subwordLength] = pending.back();
+		pending.pop_back();
+		if (subwordLength == 1) {
+			const auto& terminals = m_terminalRules[nonterminal];
+			word += terminals[engine.NextBelow(terminals.size())];
+			continue;
+		}
+
+		const double total = mf_GetLogCount(nonterminal, subwordLength);
+		double target = engine.NextDouble();
+		const BinaryRule* chosenRule = nullptr;
+		size_t chosenSplit = 0;
+		for (const BinaryRule& rule : m_binaryRules[nonterminal]) {
+			for (size_t split = 1; split < subwordLength; ++split) {
+				const double term = mf_GetLogCount(rule.first, split) + mf_GetLogCount(rule.second, subwordLength - split);
+				if (term == -std::numeric_limits<double>::infinity()) {
+					continue;
+				}
+				// The last possible choice is kept in case rounding leaves target just above the sum.
+				chosenRule = &rule;
+				chosenSplit = split;
+				target -= std::exp(term - total);
+				if (target < 0) {
+					break;
+				}
+			}
+			if (target < 0) {
+				break;
+			}
+		}
+		pending.emplace_back(chosenRule->second, subwordLength - chosenSplit);
+		pending.emplace_back(chosenRule->first, chosenSplit);
+	}
+	return word;
+}
+
+std::string WordSampler::SampleTreeUniformUpTo(size_t maxLength, RandomEngine& engine) const
+{
+	std::vector<double> logCounts;
+	for (size_t length = 0; length <= std::min(maxLength, m_maxLength); ++length) {
+		logCounts.push_back(GetLogCount(length));
+	}
+	const double total = mf_LogSumExp(logCounts);
+	if (total == -std::numeric_limits<double>::infinity()) {
+		throw "The grammar generates no word of this length.";
+	}
+	double target = engine.NextDouble();
+	size_t chosenLength = 0;
+	for (size_t length = 0; length < logCounts.size(); ++length) {
+		if (logCounts[length] == -std::numeric_limits<double>::infinity()) {
+			continue;
+		}
+		chosenLength = length;
+		target -= std::exp(logCounts[length] - total);
+		if (target < 0) {
+			break;
+		}
+	}
+	return SampleTreeUniform(chosenLength, engine);
+}
+
+uint32_t WordSampler::mf_GetNonterminalIndex(Grammar::Symbol symbol) const
+{
+	return symbol < m_nonterminalIndexes.size() ? m_nonterminalIndexes[symbol] : kNoSymbol;
+}
+
+double WordSampler::mf_GetLogCount(uint32_t nonterminal, size_t length) const
+{
+	return m_logCounts[length * m_nonterminalsCount + nonterminal];
+}
+
+void WordSampler::mf_CountTrees()
+{
+	// f(A, 1) = |{A ---> a}| and f(A, n) = sum over A ---> BC and 0 < k < n of f(B, k) * f(C, n - k),
+	// each length only needing the shorter ones.
+	m_logCounts.assign((m_maxLength + 1) * m_nonterminalsCount, -std::numeric_limits<double>::infinity());
+	std::vector<double> terms;
+	for (size_t length = 1; length <= m_maxLength; ++length) {
+		for (uint32_t nonterminal = 0; nonterminal < m_nonterminalsCount; ++nonterminal) {
+			double& logCount = m_logCounts[length * m_nonterminalsCount + nonterminal];
+			if (length == 1) {
+				if (!m_terminalRules[nonterminal].empty()) {
+					logCount = std::log(static_cast<double>(m_terminalRules[nonterminal].size()));
+				}
+				continue;
+			}
+			terms.clear();
+			for (const BinaryRule& rule : m_binaryRules[nonterminal]) {
+				for (size_t split = 1; split < length; ++split) {
+					terms.push_back(mf_GetLogCount(rule.first, split) + mf_GetLogCount(rule.second, length - split));
+				}
+			}
+			logCount = mf_LogSumExp(terms);
+		}
+	}
+}
+
+double WordSampler::mf_LogSumExp(const std::vector<double>& terms)
+{
+	double maximum = -std::numeric_limits<double>::infinity();
+	for (double term : terms) {
+		maximum = std::max(maximum, term);
+	}
+	if (maximum == -std::numeric_limits<double>::infinity()) {
+		return maximum;
+	}
+	double sum = 0;
+	for (double term : terms) {
+		sum += std::exp(term - maximum);
+	}
+	return maximum + std::log(sum);
+}
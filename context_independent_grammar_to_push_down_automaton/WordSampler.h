@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Grammar.h"
+#include "RandomEngine.h"
+
+// Sampling of words of a given length over a grammar in Chomsky normal form, uniform over derivation
+// trees. The constructor
+// counts, for every nonterminal A and length n up to the bound, the derivation trees of A yielding n
+// terminals; a word is then drawn top-down, choosing each production and split point with probability
+// proportional to the trees below it. Counts grow exponentially with n, so they are kept as natural
+// logarithms; the tables are built once and shared by every draw.
+//
+// Draws are uniform over derivation trees, not over words: a word with k trees comes out k times as often
+// as a word with one. Only for an unambiguous grammar is that uniform over words, and ambiguity cannot be
+// decided in general, so the draws are named for what they are.
+class WordSampler
+{
+public:
+	WordSampler(const Grammar& chomskyGrammar, size_t maxLength);
+
+public:
+	size_t GetMaxLength() const;
+	double GetLogCount(size_t length) const; // log of the number of trees of the start symbol, -infinity if none
+	bool HasWords(size_t length) const;
+
+public:
+	std::string SampleTreeUniform(size_t length, RandomEngine& engine) const; // the word of a uniformly drawn tree
+	std::string SampleTreeUniformUpTo(size_t maxLength, RandomEngine& engine) const; // the length itself is drawn by its count of trees
+
+private:
+	struct BinaryRule
+	{
+		uint32_t first;
+		uint32_t second;
+	};
+
+private:
+	uint32_t mf_GetNonterminalIndex(Grammar::Symbol symbol) const;
+	double mf_GetLogCount(uint32_t nonterminal, size_t length) const;
+	void mf_CountTrees();
+	static double mf_LogSumExp(const std::vector<double>& terms);
+
+private:
+	static constexpr uint32_t kNoSymbol = UINT32_MAX;
+
+private:
+	std::vector<uint32_t> m_nonterminalIndexes; // per symbol id
+	size_t m_nonterminalsCount;
+	uint32_t m_startIndex;
+	bool m_acceptsEmptyWord;
+	size_t m_maxLength;
+
+private:
+	std::vector<std::vector<std::string>> m_terminalRules; // per nonterminal, the a's of its rules A ---> a
+	std::vector<std::vector<BinaryRule>> m_binaryRules; // per nonterminal, the BC's of its rules A ---> BC
+	std::vector<double> m_logCounts; // length * m_nonterminalsCount + nonterminal
+};
@@ -0,0 +1,152 @@
+#include "WorkStealingPool.h"
+
+namespace
+{
+	uint64_t PackRange(uint64_t begin, uint64_t end)
+	{
+		return (begin << 32) | end;
+	}
+	uint64_t RangeBegin(uint64_t range)
+	{
+		return range >> 32;
+	}
+	uint64_t RangeEnd(uint64_t range)
+	{
+		return range & UINT32_MAX;
+	}
+}
+
+WorkStealingPool::WorkStealingPool(size_t threadsCount)
+	: m_ranges(new Range[threadsCount ? threadsCount : 1])
+	, m_function(nullptr)
+	, m_generation(0)
+	, m_activeWorkers(0)
+	, m_stopping(false)
+{
+	if (!threadsCount) {
+		threadsCount = 1;
+	}
+	m_threads.reserve(threadsCount);
+	for (size_t i = 0; i < threadsCount; ++i) {
+		m_ranges[i].value.store(0);
+		m_threads.emplace_back(&WorkStealingPool::mf_WorkerLoop, this, i);
+	}
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wakeUp.notify_all();
+	for (std::thread& thread : m_threads) {
+		thread.join();
+	}
+}
+
+WorkStealingPool& WorkStealingPool::GetShared()
+{
+	static WorkStealingPool pool;
+	return pool;
+}
+
+size_t WorkStealingPool::GetThreadsCount() const
+{
+	return m_threads.size();
+}
+
+void WorkStealingPool::Run(size_t chunksCount, const ChunkFunction& function)
+{
+	if (!chunksCount) {
+		return;
+	}
+	if (chunksCount > UINT32_MAX) {
+		throw "Too many chunks for one run.";
+	}
+	std::lock_guard<std::mutex> runLock(m_runMutex);
+
+	const size_t threadsCount = m_threads.size();
+	for (size_t i = 0; i < threadsCount; ++i) {
+		m_ranges[i].value.store(PackRange(chunksCount * i / threadsCount, chunksCount * (i + 1) / threadsCount));
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_function = &function;
+	m_activeWorkers = threadsCount;
+	++m_generation;
+	m_wakeUp.notify_all();
+	m_done.wait(lock, [this] { return m_activeWorkers == 0; });
+	m_function = nullptr;
+}
+
+void WorkStealingPool::mf_WorkerLoop(size_t workerIndex)
+{
+	uint64_t seenGeneration = 0;
+	while (true) {
+		const ChunkFunction* function;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeUp.wait(lock, [this, seenGeneration] { return m_stopping || m_generation != seenGeneration; });
+			if (m_stopping) {
+				return;
+			}
+			seenGeneration = m_generation;
+			function = m_function;
+		}
+
+		size_t chunkIndex;
+		while (mf_PopChunk(workerIndex, chunkIndex) || (mf_StealChunks(workerIndex) && mf_PopChunk(workerIndex, chunkIndex))) {
+			(*function)(workerIndex, chunkIndex);
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_activeWorkers == 0) {
+			m_done.notify_one();
+		}
+	}
+}
+
+bool WorkStealingPool::mf_PopChunk(size_t workerIndex, size_t& chunkIndex)
+{
+	auto& value = m_ranges[workerIndex].value;
+	uint64_t range = value.load();
+	while (RangeBegin(range) < RangeEnd(range)) {
+		if (value.compare_exchange_weak(range, PackRange(RangeBegin(range) + 1, RangeEnd(range)))) {
+			chunkIndex = static_cast<size_t>(RangeBegin(range));
+			return true;
+		}
+	}
+	return false;
+}
+
+bool WorkStealingPool::mf_StealChunks(size_t workerIndex)
+{
+	while (true) {
+		size_t victimIndex = workerIndex;
+		uint64_t victimRange = 0;
+		uint64_t largestSize = 0;
+		for (size_t i = 0; i < m_threads.size(); ++i) {
+			if (i == workerIndex) {
+				continue;
+			}
+			const uint64_t range = m_ranges[i].value.load();
+			const uint64_t size = RangeBegin(range) < RangeEnd(range) ? RangeEnd(range) - RangeBegin(range) : 0;
+			if (size > largestSize) {
+				largestSize = size;
+				victimIndex = i;
+				victimRange = range;
+			}
+		}
+		if (!largestSize) {
+			return false;
+		}
+
+		// Only the owner writes to its own empty slice, so the stolen half can be published with a plain store.
+		const uint64_t stolenBegin = RangeEnd(victimRange) - (largestSize + 1) / 2;
+		if (m_ranges[victimIndex].value.compare_exchange_strong(victimRange, PackRange(RangeBegin(victimRange), stolenBegin))) {
+			m_ranges[workerIndex].value.store(PackRange(stolenBegin, RangeEnd(victimRange)));
+			return true;
+		}
+	}
+}
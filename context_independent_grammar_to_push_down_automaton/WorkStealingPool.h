@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that split a range of chunk indexes. Every worker starts with an equal slice
+// and takes chunks from its front; once its slice is exhausted it steals the back half of the largest slice
+// left, so uneven chunks do not leave cores idle.
+class WorkStealingPool
+{
+public:
+	using ChunkFunction = std::function<void(size_t workerIndex, size_t chunkIndex)>;
+
+public:
+	WorkStealingPool(size_t threadsCount = std::thread::hardware_concurrency());
+	WorkStealingPool(const WorkStealingPool& workStealingPool) = delete;
+	~WorkStealingPool();
+
+public:
+	WorkStealingPool& operator =(const WorkStealingPool& workStealingPool) = delete;
+
+public:
+	static WorkStealingPool& GetShared();
+
+public:
+	size_t GetThreadsCount() const;
+	void Run(size_t chunksCount, const ChunkFunction& function); // blocks until every chunk has been processed
+
+private:
+	struct alignas(64) Range
+	{
+		std::atomic<uint64_t> value; // first chunk in the high half, end chunk in the low half
+	};
+
+private:
+	void mf_WorkerLoop(size_t workerIndex);
+	bool mf_PopChunk(size_t workerIndex, size_t& chunkIndex);
+	bool mf_StealChunks(size_t workerIndex);
+
+private:
+	std::vector<std::thread> m_threads;
+	std::unique_ptr<Range[]> m_ranges;
+	std::mutex m_runMutex;
+	std::mutex m_mutex;
+	std::condition_variable m_wakeUp;
+	std::condition_variable m_done;
+	const ChunkFunction* m_function;
+	uint64_t m_generation;
+	size_t m_activeWorkers;
+	bool m_stopping;
+};